@@ -0,0 +1,29 @@
+#ifndef ADPCM_H
+#define ADPCM_H
+
+#include <gba_types.h>
+
+//4 bit ima adpcm clips, made from the sfx wavs by tools/adpcm. a bank is
+//a u32 clip count, u32 offsets of the clips from the start of the bank,
+//then the clips: a header and two samples per byte, low nibble first.
+typedef struct
+{
+	u32 samples;
+	s16 predictor;
+	u8 index;
+	u8 pad;
+} Adpcm_Header;
+
+typedef struct
+{
+	const u8* data;
+	u32 left;	//samples
+	s32 predictor;
+	u8 index;
+	bool high;	//next sample is in the high nibble
+} Adpcm_Voice;
+
+bool adpcm_start(Adpcm_Voice* v, const void* bank, u16 clip);
+u32 adpcm_decode(Adpcm_Voice* v, s8* out, u32 count);	//returns samples written
+
+#endif
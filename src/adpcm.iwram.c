@@ -0,0 +1,78 @@
+//built as arm code in iwram (the .iwram.c suffix), the decoder runs for
+//every voice every frame
+#include "adpcm.h"
+
+#if defined(ADPCM) || defined(HOST)
+
+static const u16 step_table[89] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+	253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+	1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+	3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+	11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+	32767
+};
+
+static const s8 index_table[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+bool adpcm_start(Adpcm_Voice* v, const void* bank, u16 clip)
+{
+	const u32* offsets = bank;
+	if (clip >= offsets[0])
+		return false;
+
+	const Adpcm_Header* header = (const Adpcm_Header*)((const u8*)bank + offsets[1+clip]);
+	v->data = (const u8*)(header+1);
+	v->left = header->samples;
+	v->predictor = header->predictor;
+	v->index = header->index;
+	v->high = false;
+	return true;
+}
+
+u32 adpcm_decode(Adpcm_Voice* v, s8* out, u32 count)
+{
+	const u8* data = v->data;
+	s32 predictor = v->predictor;
+	s32 index = v->index;
+	bool high = v->high;
+
+	if (count > v->left)
+		count = v->left;
+
+	for (u32 i = 0; i < count; i++)
+	{
+		u8 nibble = high? (*data++ >> 4): (*data & 15);
+		high = !high;
+
+		s32 step = step_table[index];
+		s32 diff = step >> 3;
+		if (nibble & 4) diff += step;
+		if (nibble & 2) diff += step >> 1;
+		if (nibble & 1) diff += step >> 2;
+
+		predictor += (nibble & 8)? -diff: diff;
+		if (predictor > 32767)
+			predictor = 32767;
+		else if (predictor < -32768)
+			predictor = -32768;
+
+		index += index_table[nibble & 7];
+		if (index < 0)
+			index = 0;
+		else if (index > 88)
+			index = 88;
+
+		out[i] = predictor >> 8;
+	}
+
+	v->data = data;
+	v->left -= count;
+	v->predictor = predictor;
+	v->index = index;
+	v->high = high;
+	return count;
+}
+
+#endif
@@ -0,0 +1,500 @@
+#include "bench.h"
+#include "pico8.h"
+
+#include <string.h>
+
+#if defined(AUDIO_BENCH) && defined(ADPCM)
+#include "adpcm.h"
+#include "adpcm_bin.h"
+#endif
+
+
+//-- helpers --
+//-------------
+//right aligned decimal, no terminator
+static void put_num(char* str, u32 n, u8 width)
+{
+	for (s8 i = width-1; i >= 0; i--)
+	{
+		str[i] = (n > 0 || i == width-1)? (n % 10) + '0': ' ';
+		n /= 10;
+	}
+}
+
+
+//-- Audio benchmark --
+//---------------------
+#ifdef AUDIO_BENCH
+
+#define AUDIO_WARMUP 30
+#define AUDIO_FRAMES 240
+
+static const s8 tracks[5] = { 0, 10, 20, 30, 40 };
+
+//what became of the sfx() calls of the peak load, see Sfx_Stats
+enum
+{
+	SFX_REQUESTED,
+	SFX_PLAYED,
+	SFX_DEDUPED,
+	SFX_DROPPED,
+	SFX_STOLEN,
+	SFX_OUTCOMES
+};
+
+static u32 sfx_totals[SFX_OUTCOMES];
+
+//five tracks, the sfx peak and the adpcm decoder
+#ifdef ADPCM
+#define AUDIO_ROWS 7
+#else
+#define AUDIO_ROWS 6
+#endif
+
+static void audio_measure(Bench_Result* result, bool sfx_load)
+{
+	u32 total = 0;
+	result->max = 0;
+
+	for (u16 i = 0; i < AUDIO_WARMUP+AUDIO_FRAMES; i++)
+	{
+		//keep every sfx channel busy
+		if (sfx_load && i%4 == 0)
+		{
+			for (u8 n = 0; n < 64; n++)
+				sfx(n);
+		}
+
+		VBlankIntrWait();
+		u32 start = cycles();
+		update_audio();
+		u32 cost = cycles() - start;
+		update_screen();
+
+		if (i >= AUDIO_WARMUP)
+		{
+			total += cost;
+			if (cost > result->max)
+				result->max = cost;
+
+			const Sfx_Stats* stats = sfx_stats();
+			sfx_totals[SFX_REQUESTED] += stats->requested;
+			sfx_totals[SFX_PLAYED] += stats->played;
+			sfx_totals[SFX_DEDUPED] += stats->deduped;
+			sfx_totals[SFX_DROPPED] += stats->dropped;
+			sfx_totals[SFX_STOLEN] += stats->stolen;
+		}
+
+		print("audio bench...",0,0,7);
+	}
+
+	result->avg = total / AUDIO_FRAMES;
+}
+
+#ifdef ADPCM
+//22050hz clips, one frame of every sfx voice decoded per frame
+#define ADPCM_FRAME 370
+
+static void adpcm_measure(Bench_Result* result)
+{
+	static s8 out[ADPCM_FRAME] ALIGN(4);
+	Adpcm_Voice voices[SFX_CHANNELS];
+	u16 clips = ((const u32*)adpcm_bin)[0];
+	u32 total = 0;
+	result->max = 0;
+
+	for (u8 v = 0; v < SFX_CHANNELS; v++)
+		adpcm_start(&voices[v], adpcm_bin, v % clips);
+
+	for (u16 i = 0; i < AUDIO_WARMUP+AUDIO_FRAMES; i++)
+	{
+		VBlankIntrWait();
+		u32 start = cycles();
+		for (u8 v = 0; v < SFX_CHANNELS; v++)
+		{
+			//start the next clip when one ends
+			if (adpcm_decode(&voices[v], out, ADPCM_FRAME) < ADPCM_FRAME)
+				adpcm_start(&voices[v], adpcm_bin, (v + i) % clips);
+		}
+		u32 cost = cycles() - start;
+		update_audio();
+		update_screen();
+
+		if (i >= AUDIO_WARMUP)
+		{
+			total += cost;
+			if (cost > result->max)
+				result->max = cost;
+		}
+
+		print("audio bench...",0,0,7);
+	}
+
+	result->avg = total / AUDIO_FRAMES;
+}
+#endif
+
+void audio_bench()
+{
+	Bench_Result results[AUDIO_ROWS];
+
+	init_cycles();
+
+	for (u8 i = 0; i < 5; i++)
+	{
+		music(tracks[i],0,7);
+		audio_measure(&results[i], false);
+	}
+
+	//peak load: music plus every effect at once
+	music(0,0,7);
+	memset(sfx_totals, 0, sizeof(sfx_totals));
+	audio_measure(&results[5], true);
+	music(-1,0,0);
+
+#ifdef ADPCM
+	adpcm_measure(&results[6]);
+#endif
+
+	//csv log in sram for collecting results off the cartridge
+	{
+		char log[32 + AUDIO_ROWS*25 + 48 + 4 + SFX_OUTCOMES*7];
+		u16 len = 0;
+
+		strcpy(log, "track,avg,max,permille\n");
+		len = strlen(log);
+
+		for (u8 i = 0; i < AUDIO_ROWS; i++)
+		{
+			char* line = &log[len];
+			memcpy(line, (i < 5)? "mus  ,": (i == 5)? "sfx  ,": "adpcm,", 6);
+			if (i < 5)
+				put_num(line+3, tracks[i], 2);
+			put_num(line+6, results[i].avg, 6);
+			line[12] = ',';
+			put_num(line+13, results[i].max, 6);
+			line[19] = ',';
+			put_num(line+20, (results[i].avg * 1000) / CYCLES_PER_FRAME, 4);
+			line[24] = '\n';
+			len += 25;
+		}
+
+		//then the sfx() outcomes of the peak load
+		strcpy(&log[len], "sfx,requested,played,deduped,dropped,stolen\npeak");
+		len += strlen(&log[len]);
+		for (u8 i = 0; i < SFX_OUTCOMES; i++)
+		{
+			log[len] = ',';
+			put_num(&log[len+1], sfx_totals[i], 6);
+			len += 7;
+		}
+		log[len++] = '\n';
+		log[len++] = '\0';
+
+		sram_write(0, log, len);
+	}
+
+	//results table: track, average and worst cycles per frame
+	while (1)
+	{
+		char str[28];
+
+		put_num(str, MIX_RATE, 2);
+		memcpy(str+2, "khz ", 4);
+		put_num(str+6, MUSIC_CHANNELS, 2);
+		str[8] = '+';
+		put_num(str+9, SFX_CHANNELS, 2);
+		memcpy(str+11, "ch", 3);
+		print(str,0,0,7);
+
+		for (u8 i = 0; i < AUDIO_ROWS; i++)
+		{
+			memcpy(str, (i < 5)? "m   ": (i == 5)? "sfx ": "adp ", 4);
+			if (i < 5)
+				put_num(str+1, tracks[i], 2);
+			put_num(str+3, results[i].avg, 6);
+			put_num(str+9, results[i].max, 6);
+			str[15] = '\0';
+			print(str,0,16+i*8,(i < 5)? 6: (i == 5)? 10: 11);
+		}
+
+		//sfx() calls of the peak load: requested, played, deduped,
+		//dropped and stolen
+		print("  req play  dup drop  stl",0,24+AUDIO_ROWS*8,7);
+		for (u8 i = 0; i < SFX_OUTCOMES; i++)
+			put_num(str+i*5, sfx_totals[i], 5);
+		str[SFX_OUTCOMES*5] = '\0';
+		print(str,0,32+AUDIO_ROWS*8,10);
+
+		VBlankIntrWait();
+		update_audio();
+		update_screen();
+	}
+}
+
+#endif
+
+
+//-- Game benchmark --
+//--------------------
+#ifdef BENCH
+
+#define BENCH_ROWS 6
+
+#ifdef DIVCOUNT
+static const char* const subsystem_names[BENCH_SUBSYSTEMS] = { "upd", "drw", "scr", "aud", "div" };
+#else
+static const char* const subsystem_names[BENCH_SUBSYSTEMS] = { "upd", "drw", "scr", "aud" };
+#endif
+
+static EWRAM_BSS char bench_log[128 + BENCH_ROOMS*(3 + BENCH_SUBSYSTEMS*14)];
+
+//one line per room: room,update,update_max,draw,draw_max,screen,screen_max,audio,audio_max
+//and with DIVCOUNT the division calls per frame, div,div_max
+static void bench_log_write(Bench_Result results[BENCH_ROOMS][BENCH_SUBSYSTEMS])
+{
+	u16 len;
+
+	strcpy(bench_log, "room,update,update_max,draw,draw_max,screen,screen_max,audio,audio_max");
+#ifdef DIVCOUNT
+	strcat(bench_log, ",div,div_max");
+#endif
+	strcat(bench_log, "\n");
+	len = strlen(bench_log);
+
+	for (u8 r = 0; r < BENCH_ROOMS; r++)
+	{
+		put_num(&bench_log[len], r, 2);
+		len += 2;
+
+		for (u8 i = 0; i < BENCH_SUBSYSTEMS; i++)
+		{
+			bench_log[len] = ',';
+			put_num(&bench_log[len+1], results[r][i].avg, 6);
+			bench_log[len+7] = ',';
+			put_num(&bench_log[len+8], results[r][i].max, 6);
+			len += 14;
+		}
+
+		bench_log[len++] = '\n';
+	}
+	bench_log[len++] = '\0';
+
+	sram_write(0, bench_log, len);
+}
+
+//average over all rooms and the worst frame, in cycles
+static void bench_draw_summary(Bench_Result results[BENCH_ROOMS][BENCH_SUBSYSTEMS])
+{
+	char str[24];
+	u32 frame = 0;
+
+	print("avg    max rm",28,0,7);
+
+	for (u8 i = 0; i < BENCH_SUBSYSTEMS; i++)
+	{
+		u32 total = 0;
+		u8 worst = 0;
+
+		for (u8 r = 0; r < BENCH_ROOMS; r++)
+		{
+			total += results[r][i].avg;
+			if (results[r][i].max > results[worst][i].max)
+				worst = r;
+		}
+		if (i < BENCH_CYCLES)
+			frame += total / BENCH_ROOMS;
+
+		memcpy(str, subsystem_names[i], 3);
+		put_num(str+3, total / BENCH_ROOMS, 7);
+		put_num(str+10, results[worst][i].max, 7);
+		put_num(str+17, worst, 3);
+		str[20] = '\0';
+		print(str,0,16+i*8,6);
+	}
+
+	//share of the two vblanks a game frame gets
+	memcpy(str, "all", 3);
+	put_num(str+3, frame, 7);
+	put_num(str+10, (frame * 1000) / (2*CYCLES_PER_FRAME), 5);
+	memcpy(str+15, "/1000", 5);
+	str[20] = '\0';
+	print(str,0,56,10);
+}
+
+//rooms in thousands of cycles, divisions as they are
+static void bench_draw_rooms(Bench_Result results[BENCH_ROOMS][BENCH_SUBSYSTEMS], u8 first)
+{
+	char str[24];
+
+#ifdef DIVCOUNT
+	print("rm upd drw scr aud div",0,0,7);
+#else
+	print("rm upd drw scr aud",0,0,7);
+#endif
+
+	for (u8 r = first; r < first+BENCH_ROWS && r < BENCH_ROOMS; r++)
+	{
+		put_num(str, r, 2);
+		for (u8 i = 0; i < BENCH_SUBSYSTEMS; i++)
+			put_num(str+2+i*4, (i < BENCH_CYCLES)? (results[r][i].avg + 500) / 1000: results[r][i].avg, 4);
+		str[2+BENCH_SUBSYSTEMS*4] = '\0';
+		print(str,0,16+(r-first)*8,6);
+	}
+}
+
+void bench_report(Bench_Result results[BENCH_ROOMS][BENCH_SUBSYSTEMS])
+{
+	u8 page = 0;
+	u8 pages = 1 + (BENCH_ROOMS + BENCH_ROWS-1) / BENCH_ROWS;
+
+	bench_log_write(results);
+
+	//black out the last room
+	rectfill(0,0,16,16,0);
+
+	//left/right flip between the summary and the room pages
+	while (1)
+	{
+		scanKeys();
+		if (keysDown() & KEY_RIGHT)
+			page = (page+1) % pages;
+		if (keysDown() & KEY_LEFT)
+			page = (page+pages-1) % pages;
+
+		if (page == 0)
+			bench_draw_summary(results);
+		else
+			bench_draw_rooms(results, (page-1) * BENCH_ROWS);
+
+		VBlankIntrWait();
+		update_audio();
+		update_screen();
+	}
+}
+
+#endif
+
+
+//-- Frame pacing --
+//------------------
+#define PACING_ROWS 12
+
+typedef struct
+{
+	u32 frames;
+	u32 lag;
+	u32 longest;
+} Pacing_Room;
+
+static Pacing_Room pacing_rooms[PACING_ROOMS] EWRAM_BSS;	//once a frame, not hot
+static volatile u16 pacing_vblanks = 0;
+static u16 begin_vblank;
+static u32 frame_start;
+static u8 pacing_room = 0;
+static u8 pacing_page = 0;
+
+void pacing_vblank()
+{
+	pacing_vblanks += 1;
+}
+
+void pacing_begin()
+{
+	begin_vblank = pacing_vblanks;
+	frame_start = cycles();
+}
+
+//done before the 2nd vblank since the frame began, every vblank already
+//gone by makes the frame one longer
+void pacing_end(u8 room)
+{
+	u16 took = pacing_vblanks - begin_vblank;
+	u32 work = cycles() - frame_start;
+
+	if (room >= PACING_ROOMS)
+		return;
+
+	if (room != pacing_room)
+	{
+		pacing_save();
+		pacing_room = room;
+	}
+
+	Pacing_Room* r = &(pacing_rooms[room]);
+	r->frames += 1;
+	if (took > 1)
+		r->lag += took - 1;
+	if (work > r->longest)
+		r->longest = work;
+}
+
+//one line per room: room,frames,lag,longest (cycles),longest (permille of the two vblanks)
+void pacing_save()
+{
+	static EWRAM_BSS char log[32 + PACING_ROOMS*32];
+	u16 len;
+
+	strcpy(log, "room,frames,lag,longest,permille\n");
+	len = strlen(log);
+
+	for (u8 i = 0; i < PACING_ROOMS; i++)
+	{
+		Pacing_Room* r = &(pacing_rooms[i]);
+		char* line = &log[len];
+
+		put_num(line, i, 2);
+		line[2] = ',';
+		put_num(line+3, r->frames, 7);
+		line[10] = ',';
+		put_num(line+11, r->lag, 5);
+		line[16] = ',';
+		put_num(line+17, r->longest, 7);
+		line[24] = ',';
+		put_num(line+25, (r->longest * 1000ull) / (2*CYCLES_PER_FRAME), 5);
+		line[30] = '\n';
+		len += 31;
+	}
+	log[len++] = '\0';
+
+	sram_write(PACING_SRAM, log, len);
+}
+
+//room, frames played, lag frames and the longest frame in % of two vblanks
+void pacing_draw()
+{
+	u8 pages = (PACING_ROOMS + PACING_ROWS-1) / PACING_ROWS;
+	char str[24];
+	u32 lag = 0;
+
+	if (keysDown() & KEY_RIGHT)
+		pacing_page = (pacing_page+1) % pages;
+	if (keysDown() & KEY_LEFT)
+		pacing_page = (pacing_page+pages-1) % pages;
+
+	rectfill(0,0,16,16,0);
+	print("rm frames  lag max%",0,0,7);
+
+	for (u8 i = 0; i < PACING_ROOMS; i++)
+		lag += pacing_rooms[i].lag;
+
+	for (u8 i = 0; i < PACING_ROWS; i++)
+	{
+		u8 room = pacing_page*PACING_ROWS + i;
+		if (room >= PACING_ROOMS)
+			break;
+
+		Pacing_Room* r = &(pacing_rooms[room]);
+		put_num(str, room, 2);
+		put_num(str+2, r->frames, 7);
+		put_num(str+9, r->lag, 5);
+		put_num(str+14, (r->longest * 100ull) / (2*CYCLES_PER_FRAME), 5);
+		str[19] = '\0';
+		print(str,0,16+i*8,(r->lag > 0)? 8: 6);
+	}
+
+	memcpy(str, "lag", 3);
+	put_num(str+3, lag, 11);
+	str[14] = '\0';
+	print(str,0,120,(lag > 0)? 8: 11);
+}
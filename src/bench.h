@@ -0,0 +1,59 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <gba_types.h>
+
+typedef struct
+{
+	u32 avg;
+	u32 max;
+} Bench_Result;
+
+//-- Audio benchmark --
+//---------------------
+#ifdef AUDIO_BENCH
+void audio_bench();
+#endif
+
+//-- Game benchmark --
+//--------------------
+#ifdef BENCH
+#define BENCH_ROOMS 32
+
+enum {
+	BENCH_UPDATE,
+	BENCH_DRAW,
+	BENCH_SCREEN,
+	BENCH_AUDIO,
+	BENCH_CYCLES,	//the ones above are timed
+#ifdef DIVCOUNT
+	BENCH_DIVS = BENCH_CYCLES,	//library divisions in update and draw
+#endif
+};
+
+#ifdef DIVCOUNT
+#define BENCH_SUBSYSTEMS (BENCH_CYCLES+1)
+#else
+#define BENCH_SUBSYSTEMS BENCH_CYCLES
+#endif
+
+//cycles per game frame (two vblanks) of each subsystem in each room,
+//written to sram as csv and shown as a table, never returns
+void bench_report(Bench_Result results[BENCH_ROOMS][BENCH_SUBSYSTEMS]);
+#endif
+
+//-- Frame pacing --
+//------------------
+//a game frame gets two vblanks, every vblank more is a lag frame. counted
+//per room with the longest frame (cycles of work, not waiting), written to
+//sram as csv when the room changes.
+#define PACING_ROOMS 32
+#define PACING_SRAM 0x1200
+
+void pacing_vblank();	//from the vblank interrupt
+void pacing_begin();	//after frame_wait()
+void pacing_end(u8 room);	//after the frame is drawn
+void pacing_save();
+void pacing_draw();	//stats table, left/right for the pages
+
+#endif
@@ -7,21 +7,22 @@
 #include <maxmod.h>
 
 #include "pico8.h"
+#include "bench.h"
 #include <string.h>
 
 #include "fnt.h"
 #include "gfx.h"
 #include "sine.h"
 
-#include "soundbank_bin.h"
-
 
 //-- types --
 //-----------
+//the small ones keep their natural alignment, so they pack into the
+//objects next to the bytes and flags around them
 typedef struct
 {
 	s8 x, y;
-} ALIGN(4) Point;
+} Point;
 
 typedef struct
 {
@@ -30,14 +31,14 @@ typedef struct
 
 typedef struct
 {
-	bool x, y;
-} ALIGN(4) Flip;
+	bool x:1, y:1;
+} Flip;
 
 typedef struct
 {
 	s16 x, y;
 	u8 w, h;
-} ALIGN(4) Rectangle;
+} Rectangle;
 
 
 //-- object types --
@@ -64,12 +65,12 @@ enum {
 
 typedef struct
 {
-	bool active;
+	bool active:1;
+	bool collideable:1;
+	bool solids:1;
+	Flip flip;
 	u8 type;
-	bool collideable;
-	bool solids;
 	u8 spr;
-	Flip flip;
 	float x, y;
 	Rectangle hitbox;
 	Pointf spd;
@@ -84,20 +85,11 @@ typedef struct
 	u8 timer;
 } ALIGN(4) Balloon;
 
-typedef struct
-{
-	bool active;
-	s16 x, y;
-	u8 h;
-	u8 spd;
-} Big_Chest_Particle;
-
 typedef struct
 {
 	Object obj;
 	u8 state;
 	u8 timer;
-	Big_Chest_Particle particles[50];
 } ALIGN(4) Big_Chest;
 
 typedef struct
@@ -107,21 +99,13 @@ typedef struct
 	u8 timer;
 } ALIGN(4) Chest;
 
-typedef struct
-{
-	bool active;
-	float x, y;
-	u8 t;
-	Pointf spd;
-} ALIGN(4) Dead_Particle;
-
 typedef struct
 {
 	Object obj;
 	u8 state;
 	bool solid;
 	u8 delay;
-	u16* map_adr;
+	u16 map_index;	//tile x + y*32 in the map, not a pointer so host layouts match
 } ALIGN(4) Fall_Floor;
 
 typedef struct
@@ -136,8 +120,8 @@ typedef struct
 	Object obj;
 	u8 start;
 	bool fly;
-	float step;
 	u8 sfx_delay;
+	float step;
 } ALIGN(4) Fly_Fruit;
 
 typedef struct
@@ -147,11 +131,37 @@ typedef struct
 	u8 off;
 } ALIGN(4) Fruit;
 
+//every cosmetic particle in one pool of parallel arrays, positions in 24.8
+//fixed point. the free slots and the live slots of each kind are lists
+//through next[], slot 0 ends them and never holds a particle.
+enum
+{
+	fx_smoke,
+	fx_dead,
+	fx_chest,
+	fx_ambient,
+	FX_KINDS
+};
+
+#define MAX_FX 92
+
+//most of each kind alive at once, the pool holds all of them
+static const u8 fx_budget[FX_KINDS] = { 10, 8, 50, 24 };
+
 typedef struct
 {
-	float x, y;
-	u8 size;
-} ALIGN(4) Hair;
+	s32 x[MAX_FX+1], y[MAX_FX+1];
+	s16 dx[MAX_FX+1], dy[MAX_FX+1];	//per frame, dy is the phase step of ambient particles
+	u16 phase[MAX_FX+1];	//1/65536 turns
+	u8 spr[MAX_FX+1];
+	u8 t[MAX_FX+1];
+	u8 flip[MAX_FX+1];
+	u8 next[MAX_FX+1];
+	u8 head[FX_KINDS];
+	u8 count[FX_KINDS];
+	u8 free;
+	u8 fresh;	//slots handed out before the first one was freed
+} ALIGN(4) Fx;
 
 typedef struct
 {
@@ -173,15 +183,6 @@ typedef struct
 	Object obj;	
 } ALIGN(4) Orb;
 
-typedef struct
-{
-	float x, y;
-	u8 s;
-	float spd;
-	float off;
-	u8 c;
-} ALIGN(4) Particle;
-
 typedef struct
 {
 	Object obj;
@@ -191,32 +192,30 @@ typedef struct
 typedef struct
 {
 	Object obj;
-	bool p_jump;
-	bool p_dash;
+	bool p_jump:1;
+	bool p_dash:1;
+	bool was_on_ground:1;
 	u8 grace;
 	u8 jbuffer;
 	u8 djump;
 	u8 dash_time;
 	u8 dash_effect_time;
+	u8 spr_off;
 	Pointf dash_target;
 	Pointf dash_accel;
-	Rectangle hitbox;
-	u8 spr_off;
-	bool was_on_ground;
-	void (*is_ice)(u8, u8, Rectangle);
 } ALIGN(4) Player;
 
 typedef struct
 {
-	bool active;
-	s16 x, y;
+	bool active:1;
+	bool solids:1;
+	Flip flip;
 	u8 spr;
-	Point target;
-	Pointf spd;
 	u8 state;
 	u8 delay;
-	bool solids;
-	Flip flip;
+	Point target;
+	s16 x, y;
+	Pointf spd;
 } ALIGN(4) Player_Spawn;
 
 typedef struct
@@ -236,61 +235,99 @@ typedef struct
 
 //-- object lists --
 //------------------
-Big_Chest big_chest = { 0 };
-Chest chest = { 0 };
-Object fake_wall = { 0 };
-Flag flag = { 0 };
-Fly_Fruit fly_fruit = { 0 };
-Fruit fruit = { 0 };
-Object key = { 0 };
-Lifeup lifeup = { 0 };
-Message message = { 0 };
-Orb orb = { 0 };
-Player player = { 0 };
-Player_Spawn player_spawn = { 0 };
-Room_Title room_title = { 0 };
-
 #define MAX_BALLOONS 6
-Balloon balloons[MAX_BALLOONS] = { 0 };
-
-#define MAX_DEAD_PARTICLES 8
-Dead_Particle dead_particles[MAX_DEAD_PARTICLES] = { 0 };
-
 #define MAX_FALL_FLOORS 12
-Fall_Floor fall_floors[MAX_FALL_FLOORS] = { 0 };
-
 #define MAX_HAIR 5
-Hair hair[MAX_HAIR] = { 0 };
+#define MAX_PLATFORMS 10
+#define MAX_SPRINGS 5
 
-#define MAX_PARTICLES 24
-Particle particles[MAX_PARTICLES] = { 0 };
 
-#define MAX_PLATFORMS 10
-Platform platforms[MAX_PLATFORMS] = { 0 };
+//big chest, memorial message and summit flag (level_index() 21, 11 and 30):
+//one of them per room at most, so they share their storage. obj.type says which
+//one it is, see landmark().
+typedef union
+{
+	Object obj;
+	Big_Chest big_chest;
+	Flag flag;
+	Message message;
+} Landmark;
 
-#define MAX_SMOKE 10
-Object smoke[MAX_SMOKE] = { 0 };
+#define landmark(t) (g->landmark.obj.active && g->landmark.obj.type == (t))
 
-#define MAX_SPRINGS 5
-Spring springs[MAX_SPRINGS] = { 0 };
+
+//-- game state --
+//----------------
+//everything the simulation reads and writes. the gba runs one game at a
+//fixed address, host tools give every thread its own and point g at it.
+typedef struct
+{
+	//objects
+	Landmark landmark;
+	Chest chest;
+	Object fake_wall;
+	Fly_Fruit fly_fruit;
+	Fruit fruit;
+	Object key;
+	Lifeup lifeup;
+	Orb orb;
+	Player player;
+	Player_Spawn player_spawn;
+	Room_Title room_title;
+
+	Fx fx;
+	Balloon balloons[MAX_BALLOONS];
+	Fall_Floor fall_floors[MAX_FALL_FLOORS];
+	s32 hair_x[MAX_HAIR];	//24.8 fixed point
+	s32 hair_y[MAX_HAIR];
+	Platform platforms[MAX_PLATFORMS];
+	Spring springs[MAX_SPRINGS];
+
+	//globals, flags packed together after the wider fields
+	u32 fruits;	//a bit per level, see got_fruit()
+	Point room;
+	u8 freeze;
+	u8 shake;
+	u8 delay_restart;
+	u8 sfx_timer;
+	u8 music_timer;
+	bool cheated:1;
+	bool will_restart:1;
+	bool has_dashed:1;
+	bool has_key:1;
+	bool pause_player:1;
+	bool flash_bg:1;
+	bool start_game:1;
+	bool new_bg:1;
+	bool practice:1;	//a quick load was used, splits aren't kept
+
+	//input
+	u16 kheld;
+	u16 kdown;
+
+	u8 frames;
+	u8 seconds;
+	u8 minutes;
+	u8 max_djump;
+	u32 run_frames;	//frame precise run time
+	u32 room_start;	//run_frames when the room was entered
+	s16 start_game_flash;
+	u16 deaths;
+} Game;
+
+#define GAME_INIT { .max_djump = 1 }
+
+Game game = GAME_INIT;
+#ifdef HOST
+THREAD_LOCAL Game* g = &game;
+#else
+#define g (&game)
+#endif
 
 
 //-- globals --
 //-------------
-Point room = { 0, 0 };
-u8 freeze = 0;
-u8 shake = 0;
-bool cheated = false;
 bool can_shake = true;
-bool will_restart = false;
-u8 delay_restart = 0;
-bool got_fruit[32] = { false };
-bool has_dashed = false;
-u8 sfx_timer = 0;
-bool has_key = false;
-bool pause_player = false;
-bool flash_bg = false;
-u8 music_timer = 0;
 
 #define k_left KEY_LEFT
 #define k_right KEY_RIGHT
@@ -299,43 +336,40 @@ u8 music_timer = 0;
 #define k_jump KEY_A
 #define k_dash KEY_B
 
-static u16 kheld = 0;
-static u16 kdown = 0;
-
-bool start_game = false;
-
-u8 frames = 0;
-u8 seconds = 0;
-u8 minutes = 0;
-u8 max_djump = 1;
-s16 start_game_flash = 0;
-u16 deaths = 0;
-bool new_bg = false;
-
 
 //-- room function prototypes --
 //-------------------------
-#define level_index() (room.x%8+room.y*8)
+#define level_index() (g->room.x%8+g->room.y*8)
+#define got_fruit(level) ((g->fruits >> (level)) & 1)
 #define is_title() (level_index()==31)
 void restart_room();
 void load_room(u8 x, u8 y);
 void next_room();
+void end_split();
+void draw_delta(u8 x, u8 y);
 
 
 //-- helper functions --
 //----------------------
-#define btn(x) ((kheld & (x))? 1: 0)
-#define btnp(x) ((kdown & (x))? 1: 0)
+#define btn(x) ((g->kheld & (x))? 1: 0)
+#define btnp(x) ((g->kdown & (x))? 1: 0)
 
 #define abs(x) ( ((x) < 0)? -(x): (x) )
-#define cos(x) (COS[(u16)((x)*360) % 360])
-#define sin(x) (SIN[(u16)((x)*360) % 360])
+#define cos(x) (COS[mod360((u16)((x)*360))])
+#define sin(x) (SIN[mod360((u16)((x)*360))])
 
 #define clamp(val,a,b) ( max((a), min((b), (val))) )
 #define appr(val,target,amount) ( ((val) > (target))? max((val) - (amount), (target)): min((val) + (amount), (target)))
 #define sign(v) ( ((v) > 0) - ((v) < 0) )
 #define maybe() (rndi(2) < 1)
 
+//g->frames/30.f, a float division per use otherwise
+static const float frame_turns[30] = {
+	0/30.f, 1/30.f, 2/30.f, 3/30.f, 4/30.f, 5/30.f, 6/30.f, 7/30.f, 8/30.f, 9/30.f,
+	10/30.f, 11/30.f, 12/30.f, 13/30.f, 14/30.f, 15/30.f, 16/30.f, 17/30.f, 18/30.f, 19/30.f,
+	20/30.f, 21/30.f, 22/30.f, 23/30.f, 24/30.f, 25/30.f, 26/30.f, 27/30.f, 28/30.f, 29/30.f
+};
+
 u8 tile_at(u8 x, u8 y)
 {
 	u16* map_adr = MAP_BASE_ADR(4);
@@ -344,6 +378,7 @@ u8 tile_at(u8 x, u8 y)
 
 bool tile_flag_at(u8 x, u8 y, u8 w, u8 h, u8 flag)
 {
+	cost_count(COST_TILE_FLAG);
 	for (u8 i = max(0,flr(x/8)); i <= min(15,(x+w-1)/8); i++) {
 		for (u8 j = max(0,flr(y/8)); j <= min(15,(y+h-1)/8); j++) {
 			if (fget(tile_at(i,j),flag)) {
@@ -394,7 +429,7 @@ bool spikes_at(u8 x, u8 y, u8 w, u8 h, float xspd, float yspd)
 
 void psfx(u8 num)
 {
-	if (sfx_timer <= 0) {
+	if (g->sfx_timer <= 0) {
 		sfx(num);
 	}
 }
@@ -422,13 +457,13 @@ Object* collide(Object* obj, u8 type, s8 ox, s8 oy)
 	switch (type)
 	{
 		case type_player:
-			return collide_check(obj,&(player.obj),ox,oy);
+			return collide_check(obj,&(g->player.obj),ox,oy);
 			break;
 
 		case type_fake_wall:
 		{
-			if (fake_wall.active)
-				return collide_check(obj,&fake_wall,ox,oy);
+			if (g->fake_wall.active)
+				return collide_check(obj,&g->fake_wall,ox,oy);
 		}
 		break;
 
@@ -437,7 +472,7 @@ Object* collide(Object* obj, u8 type, s8 ox, s8 oy)
 			Object* other;
 			for (u8 i = 0; i < MAX_PLATFORMS; i++)
 			{
-				other = &(platforms[i].obj);
+				other = &(g->platforms[i].obj);
 				if (!other->active)
 					break;
 				else
@@ -455,7 +490,7 @@ Object* collide(Object* obj, u8 type, s8 ox, s8 oy)
 			Object* other;
 			for (u8 i = 0; i < MAX_SPRINGS; i++)
 			{
-				other = &(springs[i].obj);
+				other = &(g->springs[i].obj);
 				if (!other->active)
 					break;
 				else
@@ -473,7 +508,7 @@ Object* collide(Object* obj, u8 type, s8 ox, s8 oy)
 			Object* other;
 			for (u8 i = 0; i < MAX_FALL_FLOORS; i++)
 			{
-				other = &(fall_floors[i].obj);
+				other = &(g->fall_floors[i].obj);
 				if (!other->active)
 					break;
 				else
@@ -505,13 +540,13 @@ inline bool platform_check()
 	Platform* p;
 	for (u8 i = 0; i < MAX_PLATFORMS; i++)
 	{
-		p = &(platforms[i]);
+		p = &(g->platforms[i]);
 
 		if (!p->obj.active)
 			return false;
 
-		if (player.obj.y != p->obj.y - 8 ||
-			player.obj.x + player.obj.hitbox.x >= p->obj.x + 16 || player.obj.x + player.obj.hitbox.x + player.obj.hitbox.w <= p->obj.x)
+		if (g->player.obj.y != p->obj.y - 8 ||
+			g->player.obj.x + g->player.obj.hitbox.x >= p->obj.x + 16 || g->player.obj.x + g->player.obj.hitbox.x + g->player.obj.hitbox.w <= p->obj.x)
 			continue;
 
 		return true;
@@ -522,6 +557,7 @@ inline bool platform_check()
 
 bool is_solid(Object* obj, s8 ox, s8 oy)
 {
+	cost_count(COST_SOLID);
 	if (oy > 0 && platform_check()) {
 		return true;
 	}
@@ -529,46 +565,69 @@ bool is_solid(Object* obj, s8 ox, s8 oy)
 		|| check(obj,type_fake_wall,ox,oy);
 }
 
-void draw_time(u8 x, u8 y)
+//"hh:mm:ss" of seconds/minutes, kept up to date as the timer ticks
+static THREAD_LOCAL char time_str[9] = "00:00:00";
+
+void format_time()
 {
-	char str[9] = "00:00:00";
+	u8 s = g->seconds;
+	u8 m = g->minutes%60;
+	u8 h = g->minutes/60;
 
-	u8 s = seconds;
-	u8 m = minutes%60;
-	u8 h = flr(minutes/60.f);
+	time_str[0] = div10(h) + '0';
+	time_str[1] = mod10(h) + '0';
 
-	//rectfill
-	str[0] = (h/10) + '0';
-	str[1] = (h%10) + '0';
+	time_str[3] = div10(m) + '0';
+	time_str[4] = mod10(m) + '0';
 
-	str[3] = (m/10) + '0';
-	str[4] = (m%10) + '0';
+	time_str[6] = div10(s) + '0';
+	time_str[7] = mod10(s) + '0';
+}
 
-	str[6] = (s/10) + '0';
-	str[7] = (s%10) + '0';
+//advance by a second, only the digits that change are touched
+void tick_time()
+{
+	if (++time_str[7] <= '9')
+		return;
+	time_str[7] = '0';
+
+	if (++time_str[6] <= '5')
+		return;
+
+	//-- new minute
+	format_time();
+}
 
-	print(str,x+1,y+1,7);
+void draw_time(u8 x, u8 y)
+{
+	print(time_str,x+1,y+1,7);
 }
 
 
 //-- entry point --
 //-----------------
 void title_screen();
+void load_splits();
+void start_splits();
+void fx_reset();
+u8 fx_new(u8 kind);
 
 void __init()
 {
-	for (u8 i = 0; i < MAX_PARTICLES; i++)
+	load_splits();
+
+	fx_reset();
+	for (u8 n = 0; n < fx_budget[fx_ambient]; n++)
 	{
-		Particle* this = &(particles[i]);
-		this->x = rndi(128);
-		this->y = rndi(128);
-		//this->y = rndi(64);
-		this->s = 0;
+		u8 i = fx_new(fx_ambient);
+		g->fx.x[i] = rndi(128) << 8;
+		g->fx.y[i] = rndi(128) << 8;
+		g->fx.spr[i] = 128;
 		if (rndi(3) < 1)
-			this->s = 1;
-		this->spd = 0.25+rndi(5);
-		this->off = rnd(1);
-		this->c = 6+flr(0.5+rnd(1));
+			g->fx.spr[i] = 129;
+		g->fx.dx[i] = 64 + (rndi(5) << 8);
+		g->fx.dy[i] = min(3277, g->fx.dx[i] << 3);	//min(0.05, spd/32) turns
+		g->fx.phase[i] = rndi(100) * 65536 / 100;
 	}
 
 	title_screen();
@@ -576,32 +635,37 @@ void __init()
 
 void title_screen()
 {
-	for (u8 i = 0; i < 32; i++)
-		got_fruit[i] = false;
-	frames = 0;
-	seconds = 0;
-	minutes = 0;
-	deaths = 0;
-	max_djump = 1;
-	start_game = false;
-	start_game_flash = 0;
-	cheated = false;
-
-	new_bg = false;
+	g->fruits = 0;
+	g->frames = 0;
+	g->seconds = 0;
+	g->minutes = 0;
+	format_time();
+	g->deaths = 0;
+	g->max_djump = 1;
+	g->start_game = false;
+	g->start_game_flash = 0;
+	g->cheated = false;
+
+	g->new_bg = false;
 
 	music(40,0,7);
 
 	load_room(7,3);
-	player_spawn.active = false;
+	g->player_spawn.active = false;
 }
 
 void begin_game()
 {
-	frames = 0;
-	seconds = 0;
-	minutes = 0;
-	music_timer = 0;
-	start_game = false;
+	g->frames = 0;
+	g->seconds = 0;
+	g->minutes = 0;
+	format_time();
+	g->run_frames = 0;
+	g->room_start = 0;
+	g->practice = false;
+	start_splits();
+	g->music_timer = 0;
+	g->start_game = false;
 	music(0,0,7);
 	load_room(0,0);
 }
@@ -642,13 +706,149 @@ void draw_object(Object* obj)
 
 //-- effects --
 //-------------
+void fx_reset()
+{
+	memset(g->fx.head, 0, sizeof(g->fx.head));
+	memset(g->fx.count, 0, sizeof(g->fx.count));
+	g->fx.free = 0;
+	g->fx.fresh = 0;
+}
+
+//a cleared slot at the front of the kind's list, 0 when its budget or the
+//pool is used up
+u8 fx_new(u8 kind)
+{
+	Fx* fx = &(g->fx);
+	u8 i = fx->free;
+
+	if (fx->count[kind] >= fx_budget[kind])
+		return 0;
+	if (i != 0)
+		fx->free = fx->next[i];
+	else if (fx->fresh < MAX_FX)
+		i = ++fx->fresh;
+	else
+		return 0;
+
+	fx->next[i] = fx->head[kind];
+	fx->head[kind] = i;
+	fx->count[kind] += 1;
+
+	fx->dx[i] = fx->dy[i] = 0;
+	fx->phase[i] = 0;
+	fx->spr[i] = fx->t[i] = fx->flip[i] = 0;
+	return i;
+}
+
+void fx_clear(u8 kind)
+{
+	Fx* fx = &(g->fx);
+	while (fx->head[kind] != 0)
+	{
+		u8 i = fx->head[kind];
+		fx->head[kind] = fx->next[i];
+		fx->next[i] = fx->free;
+		fx->free = i;
+	}
+	fx->count[kind] = 0;
+}
+
+//moves and draws one particle, false once it's gone
+static bool fx_step(Fx* fx, u8 kind, u8 i)
+{
+	fx->x[i] += fx->dx[i];
+
+	switch (kind)
+	{
+		case fx_smoke:
+			fx->y[i] += fx->dy[i];
+			if (mod5(g->frames) == 0 && ++fx->spr[i] >= 32)
+				return false;
+			spr(fx->spr[i], (fx->x[i]+128) >> 8, (fx->y[i]+128) >> 8, 1, 0, fx->flip[i] & 1, fx->flip[i] >> 1);
+			return true;
+
+		case fx_dead:
+			fx->y[i] += fx->dy[i];
+			fx->t[i] -= 1;
+			pal(7,14+fx->t[i]%2,PAL_PLAYER);
+			spr(128+min(fx->t[i]/2,3), (fx->x[i] >> 8)-4, (fx->y[i] >> 8)-4, 1, PAL_PLAYER, 0, 0);
+			return fx->t[i] > 0;
+
+		case fx_chest:
+		{
+			fx->y[i] += fx->dy[i];
+			s16 x = fx->x[i] >> 8, y = fx->y[i] >> 8;
+			spr(139,x,y,1,0,0,0);
+			spr(139,x,y-8,1,0,0,0);
+			spr(139,x,y-16,1,0,0,0);
+			spr(139,x,y-24,1,0,0,0);
+			return y >= 0;
+		}
+
+		default:
+			fx->y[i] += SIN_FIX[(fx->phase[i]*360) >> 16];
+			fx->phase[i] += fx->dy[i];
+			spr(fx->spr[i], fx->x[i] >> 8, fx->y[i] >> 8, 1, 0, 0, 0);
+			if (fx->x[i] > (128+4) << 8) {
+				fx->x[i] = -(4 << 8);
+				fx->y[i] = rndi(128) << 8;
+			}
+			return true;
+	}
+}
+
+//the whole pool in one pass, kind by kind so they stack the same every frame
+void fx_draw()
+{
+	Fx* fx = &(g->fx);
+
+	for (u8 kind = 0; kind < FX_KINDS; kind++)
+	{
+		u8* link = &(fx->head[kind]);
+		while (*link != 0)
+		{
+			u8 i = *link;
+			if (fx_step(fx, kind, i))
+			{
+				link = &(fx->next[i]);
+				continue;
+			}
+
+			*link = fx->next[i];
+			fx->next[i] = fx->free;
+			fx->free = i;
+			fx->count[kind] -= 1;
+		}
+	}
+}
+
+static const u8 hair_size[MAX_HAIR] = { 3, 3, 2, 1, 1 };
+
+//each segment moves 2/3 of the way to the one before it, as a multiply by
+//the reciprocal of 1.5 in 0.16 (fine while segments are < 192px apart)
+#define HAIR_FOLLOW 0xaaab
+
 void create_hair(s16 x, s16 y)
 {
 	for (u8 i = 0; i < MAX_HAIR; i++)
 	{
-		hair[i].x = x;
-		hair[i].y = y;
-		hair[i].size = max(1,min(3,4-i));
+		g->hair_x[i] = x << 8;
+		g->hair_y[i] = y << 8;
+	}
+}
+
+//once per update, after the player moved
+void hair_update(s16 x, s16 y, s8 facing)
+{
+	s32 last_x = (x+4-facing*2) << 8;
+	s32 last_y = (y+(btn(k_down)? 4: 3)) << 8;
+
+	for (u8 i = 0; i < MAX_HAIR; i++)
+	{
+		g->hair_x[i] += ((last_x - g->hair_x[i]) * HAIR_FOLLOW) >> 16;
+		g->hair_y[i] += ((last_y + 128 - g->hair_y[i]) * HAIR_FOLLOW) >> 16;
+		last_x = g->hair_x[i];
+		last_y = g->hair_y[i];
 	}
 }
 
@@ -657,25 +857,15 @@ void set_hair_color(u8 djump)
 	if (djump == 1)
 		pal(8, 8, PAL_PLAYER);
 	else if (djump == 2)
-		pal(8, 7+flr((frames/3)%2)*4, PAL_PLAYER);
+		pal(8, 7+(div3(g->frames) & 1)*4, PAL_PLAYER);
 	else
 		pal(8,12, PAL_PLAYER);
 }
 
-void draw_hair(float x, float y, s8 facing)
+void draw_hair()
 {
-	Hair temp = { x+4-facing*2, y+(btn(k_down)? 4: 3), 3 };
-	Hair* last = &temp;
-	Hair* h;
-
 	for (u8 i = 0; i < MAX_HAIR; i++)
-	{
-		h = &(hair[i]);
-		h->x += (last->x-h->x)/1.5f;
-		h->y += (last->y+0.5-h->y)/1.5f;
-		spr(131+h->size, h->x-3, h->y-3, 1, PAL_PLAYER, 0, 0);
-		last = h;
-	}
+		spr(131+hair_size[i], (g->hair_x[i] >> 8)-3, (g->hair_y[i] >> 8)-3, 1, PAL_PLAYER, 0, 0);
 }
 
 
@@ -699,7 +889,7 @@ void lifeup_draw(Lifeup* this)
 	}
 	else
 	{
-		if (frames%2 == 0)
+		if (g->frames%2 == 0)
 			this->flash += 1;
 
 		print("1000",this->obj.x,this->obj.y,7+(this->flash%2));
@@ -709,36 +899,17 @@ void lifeup_draw(Lifeup* this)
 
 void smoke_init(s16 x, s16 y)
 {
-	for (u8 i = 0; i < MAX_SMOKE; i++)
-	{
-		Object* this = &(smoke[i]);
-		if (!this->active)
-		{			
-			init_object(this, type_smoke, x, y);
-
-			this->spr = 29;
-			this->spd.y = -0.1;
-			this->spd.x = 0.3 + rnd(0.2);
-			this->x += -1 + rndi(2);
-			this->y += -1 + rndi(2);
-			this->flip.x = maybe();
-			this->flip.y = maybe();
-			this->solids = false;
-
-			break;
-		}
-	}
-}
+	u8 i = fx_new(fx_smoke);
+	if (i == 0)
+		return;
 
-void smoke_update(Object* this)
-{
-	if (frames % 5 == 0)
-	{
-		this->spr += 1;
-		if (this->spr >= 32) {
-			this->active = false;
-		}
-	}
+	g->fx.spr[i] = 29;
+	g->fx.dy[i] = -26;	//-0.1
+	g->fx.dx[i] = 77 + rndi(20)*256/100;	//0.3 + rnd(0.2)
+	g->fx.x[i] = (x-1+rndi(2)) << 8;
+	g->fx.y[i] = (y-1+rndi(2)) << 8;
+	g->fx.flip[i] = maybe();
+	g->fx.flip[i] |= maybe() << 1;
 }
 
 
@@ -807,7 +978,7 @@ void player_init(Player* this, u8 x, u8 y)
 	this->p_dash = false;
 	this->grace = 0;
 	this->jbuffer = 0;
-	this->djump = max_djump;
+	this->djump = g->max_djump;
 	this->dash_time = 0;
 	this->dash_effect_time = 0;
 	this->dash_target.x = 0;
@@ -826,30 +997,29 @@ void player_init(Player* this, u8 x, u8 y)
 
 void kill_player()
 {
-	sfx_timer = 12;
+	g->sfx_timer = 12;
 	sfx(0);
-	deaths += 1;
-	shake = 10;
-	player.obj.active = false;
+	g->deaths += 1;
+	g->shake = 10;
+	g->player.obj.active = false;
 	for (u8 dir = 0; dir <= 7; dir++)
 	{
-		Dead_Particle* obj = &(dead_particles[dir]);
-
-		float angle = (dir/8.f);
+		u8 i = fx_new(fx_dead);
+		if (i == 0)
+			break;
 
-		obj->active = true;
-		obj->x = player.obj.x+4;
-		obj->y = player.obj.y+4;
-		obj->t = 10;
-		obj->spd.x = sin(angle)*3;
-		obj->spd.y = cos(angle)*3;
+		g->fx.x[i] = (s16)(g->player.obj.x+4) << 8;
+		g->fx.y[i] = (s16)(g->player.obj.y+4) << 8;
+		g->fx.t[i] = 10;
+		g->fx.dx[i] = SIN_FIX[dir*45]*3;
+		g->fx.dy[i] = SIN_FIX[(dir*45+90)%360]*3;
 	}
 	restart_room();
 }
 
 void player_update(Player* this)
 {
-	if (pause_player) return;
+	if (g->pause_player) return;
 
 	s8 input = btn(k_right) - btn(k_left);
 
@@ -881,9 +1051,9 @@ void player_update(Player* this)
 
 	if (on_ground) {
 		this->grace = 6;
-		if (this->djump < max_djump) {
+		if (this->djump < g->max_djump) {
 			psfx(54);
-			this->djump = max_djump;
+			this->djump = g->max_djump;
 		}
 	}
 	else if (this->grace > 0) {
@@ -979,7 +1149,7 @@ void player_update(Player* this)
 			smoke_init(this->obj.x,this->obj.y);
 			this->djump -= 1;
 			this->dash_time = 4;
-			has_dashed = true;
+			g->has_dashed = true;
 			this->dash_effect_time = 10;
 			s8 v_input = (btn(k_down) - btn(k_up));
 			if (input != 0) {
@@ -1007,8 +1177,8 @@ void player_update(Player* this)
 			}
 
 			psfx(3);
-			freeze = 2;
-			shake = 6;
+			g->freeze = 2;
+			g->shake = 6;
 			this->dash_target.x = 2*sign(this->obj.spd.x);
 			this->dash_target.y = 2*sign(this->obj.spd.y);
 			this->dash_accel.x = 1.5;
@@ -1032,7 +1202,7 @@ void player_update(Player* this)
 	}
 
 	//-- animation
-	if (frames%4 == 0)
+	if (g->frames%4 == 0)
 		this->spr_off += 1;
 	
 	if (!on_ground) {
@@ -1067,7 +1237,7 @@ void player_draw(Player* this)
 
 	set_hair_color(this->djump);
 	spr(this->obj.spr,this->obj.x,this->obj.y,1,PAL_PLAYER,this->obj.flip.x,this->obj.flip.y);
-	draw_hair(this->obj.x,this->obj.y,(this->obj.flip.x)? -1: 1);
+	draw_hair();
 
 	//-- next level
 	if (this->obj.y < -4 && level_index() < 30) { next_room(); }
@@ -1117,7 +1287,7 @@ void player_spawn_update(Player_Spawn* this)
 			this->spd.y = 0;
 			this->state = 2;
 			this->delay = 5;
-			shake = 5;
+			g->shake = 5;
 			smoke_init(this->x,this->y+4);
 			sfx(5);
 		}
@@ -1128,16 +1298,16 @@ void player_spawn_update(Player_Spawn* this)
 		this->spr = 6;
 		if (this->delay == 0) {
 			this->active = false;
-			player_init(&player,this->x,this->y);
+			player_init(&g->player,this->x,this->y);
 		}
 	}
 }
 
 void player_spawn_draw(Player_Spawn* this)
 {
-	set_hair_color(max_djump);
+	set_hair_color(g->max_djump);
 	spr(this->spr,this->x,this->y,1,PAL_PLAYER,this->flip.x,this->flip.y);
-	draw_hair(this->x,this->y,1);
+	draw_hair();
 }
 
 
@@ -1145,29 +1315,29 @@ void player_spawn_draw(Player_Spawn* this)
 //----------------------
 void orb_init(u8 x, u8 y)
 {
-	init_object(&(orb.obj),type_orb,x,y);
-	orb.obj.spd.y = -4;
-	orb.obj.solids = false;
+	init_object(&(g->orb.obj),type_orb,x,y);
+	g->orb.obj.spd.y = -4;
+	g->orb.obj.solids = false;
 }
 
 void orb_draw(Orb* this)
 {
 	this->obj.spd.y = appr(this->obj.spd.y,0,0.5);
 	if (this->obj.spd.y == 0) {
-		if (collide_check(&(this->obj), &(player.obj), 0, 0)) {
-			music_timer = 45;
+		if (collide_check(&(this->obj), &(g->player.obj), 0, 0)) {
+			g->music_timer = 45;
 			sfx(51);
-			freeze = 10;
-			shake = 10;
+			g->freeze = 10;
+			g->shake = 10;
 			this->obj.active = false;
-			max_djump = 2;
-			player.djump = 2;
+			g->max_djump = 2;
+			g->player.djump = 2;
 		}
 	}
 
 	spr(102,this->obj.x,this->obj.y,1,0,0,0);
 
-	float off = frames / 30.f;
+	float off = frame_turns[g->frames];
 	for (u8 i = 0; i < 8; i++)
 		spr(140,this->obj.x+1+cos(off+i/8.f)*8,this->obj.y+1+sin(off+i/8.f)*8,1,0,0,0);
 }
@@ -1175,31 +1345,23 @@ void orb_draw(Orb* this)
 
 void big_chest_init(u8 x, u8 y)
 {
-	init_object(&(big_chest.obj),type_big_chest,x,y);
-	big_chest.state = 0;
-	big_chest.obj.hitbox.w = 16;
-	big_chest.obj.hitbox.h = 16;
-	big_chest.timer = 0;
-
-	for (u8 i = 0; i < 50; i++)
-	{
-		big_chest.particles[i].active = false;
-		big_chest.particles[i].x = 0;
-		big_chest.particles[i].y = 0;
-		big_chest.particles[i].h = 0;
-		big_chest.particles[i].spd = 0;
-	}
+	init_object(&(g->landmark.big_chest.obj),type_big_chest,x,y);
+	g->landmark.big_chest.state = 0;
+	g->landmark.big_chest.obj.hitbox.w = 16;
+	g->landmark.big_chest.obj.hitbox.h = 16;
+	g->landmark.big_chest.timer = 0;
+	fx_clear(fx_chest);
 }
 
 void big_chest_draw(Big_Chest* this)
 {
 	if (this->state == 0) {
-		if (collide_check(&(this->obj),&(player.obj),0,0) && is_solid(&(player.obj),0,1)) {
+		if (collide_check(&(this->obj),&(g->player.obj),0,0) && is_solid(&(g->player.obj),0,1)) {
 			music(-1,500,7);
 			sfx(37);
-			pause_player = true;
-			player.obj.spd.x = 0;
-			player.obj.spd.y = 0;
+			g->pause_player = true;
+			g->player.obj.spd.x = 0;
+			g->player.obj.spd.y = 0;
 			this->state = 1;
 			smoke_init(this->obj.x, this->obj.y);
 			smoke_init(this->obj.x+8, this->obj.y);
@@ -1210,44 +1372,24 @@ void big_chest_draw(Big_Chest* this)
 	}
 	else if (this->state == 1) {
 		this->timer -= 1;
-		shake = 5;
-		flash_bg = true;
+		g->shake = 5;
+		g->flash_bg = true;
 		if (this->timer <= 45) {
-			for (u8 i = 0; i < 50; i++) {
-				Big_Chest_Particle* p = &(this->particles[i]);
-				if (!p->active)
-				{
-					p->active = true;
-					p->x = this->obj.x + 1 + rndi(14);
-					p->y = this->obj.y+8;
-					p->h = 32+rndi(32);
-					p->spd = 8 + rndi(8);
-					break;
-				}
+			u8 i = fx_new(fx_chest);
+			if (i != 0) {
+				g->fx.x[i] = (s16)(this->obj.x + 1 + rndi(14)) << 8;
+				g->fx.y[i] = (s16)(this->obj.y+8) << 8;
+				g->fx.dy[i] = -((8 + rndi(8)) << 8);
 			}
 		}
 		if (this->timer <= 0) {
 			this->state = 2;
 
-			flash_bg = false;
-			new_bg = true;
+			g->flash_bg = false;
+			g->new_bg = true;
 			orb_init(this->obj.x+4,this->obj.y+4);
-			pause_player = false;
-		}
-
-		for (u8 i = 0; i < 50; i++)
-		{
-			Big_Chest_Particle* p = &(this->particles[i]);
-			if (p->active)
-			{
-				p->y -= p->spd;
-				if (p->y < 0) p->active = false;
-
-				spr(139,p->x,p->y,1,0,0,0);
-				spr(139,p->x,p->y-8,1,0,0,0);
-				spr(139,p->x,p->y-16,1,0,0,0);
-				spr(139,p->x,p->y-24,1,0,0,0);
-			}
+			g->pause_player = false;
+			fx_clear(fx_chest);
 		}
 	}
 	spr(112,this->obj.x,this->obj.y+8,1,0,0,0);
@@ -1260,7 +1402,7 @@ void add_balloon(u8 x, u8 y)
 	Balloon* this;
 	for (u8 i = 0; i < MAX_BALLOONS; i++)
 	{
-		this = &(balloons[i]);
+		this = &(g->balloons[i]);
 		if (this->obj.active == false)
 		{
 			init_object(&(this->obj), type_balloon, x, y);
@@ -1283,11 +1425,11 @@ void balloon_update(Balloon* this)
 	if (this->obj.spr == 22) {
 		this->offset += 0.01;
 		this->obj.y = this->start + sin(this->offset)*2;
-		if (player.djump < max_djump) {
-			if (collide_check(&(this->obj), &(player.obj), 0, 0)) {
+		if (g->player.djump < g->max_djump) {
+			if (collide_check(&(this->obj), &(g->player.obj), 0, 0)) {
 				psfx(6);
 				smoke_init(this->obj.x, this->obj.y);
-				player.djump = max_djump;
+				g->player.djump = g->max_djump;
 				this->obj.spr = 0;
 				this->timer = 60;
 			}
@@ -1307,8 +1449,15 @@ void balloon_update(Balloon* this)
 void balloon_draw(Balloon* this)
 {
 	if (this->obj.spr == 22) {
+		//the offset grows as long as the room is played (to 262144, where
+		//+0.01 stops changing it). mod3() is exact below 98304, so fold the
+		//phase into 17 bits first: 65536 % 3 == 1 keeps the remainder.
+		u32 phase = (u32)(this->offset*8);
+		phase = (phase >> 16) + (phase & 0xffff);
+		phase = (phase >> 16) + (phase & 0xffff);
+
 		spr(this->obj.spr, this->obj.x, this->obj.y, 1, 0, 0, 0);
-		spr(13+((int)(this->offset*8)%3), this->obj.x, this->obj.y+6, 1, 0, 0, 0);
+		spr(13+mod3(phase), this->obj.x, this->obj.y+6, 1, 0, 0, 0);
 	}
 }
 
@@ -1337,7 +1486,7 @@ void add_spring(u8 x, u8 y)
 {
 	for (u8 i = 0; i < MAX_SPRINGS; i++)
 	{
-		Spring* this = &(springs[i]);
+		Spring* this = &(g->springs[i]);
 		if (this->obj.active == false)
 		{
 			init_object(&(this->obj), type_spring, x, y);
@@ -1359,14 +1508,14 @@ void spring_update(Spring* this)
 		}
 	}
 	else if (this->obj.spr == 18) {
-		if (player.obj.spd.y >= 0)
+		if (g->player.obj.spd.y >= 0)
 		{
-			if (collide_check(&(this->obj), &(player.obj), 0, 0)) {
+			if (collide_check(&(this->obj), &(g->player.obj), 0, 0)) {
 				this->obj.spr = 19;
-				player.obj.y = this->obj.y-4;
-				player.obj.spd.x *= 0.2;
-				player.obj.spd.y = -3;
-				player.djump = max_djump;
+				g->player.obj.y = this->obj.y-4;
+				g->player.obj.spd.x *= 0.2;
+				g->player.obj.spd.y = -3;
+				g->player.djump = g->max_djump;
 				this->delay = 10;
 				smoke_init(this->obj.x, this->obj.y);
 
@@ -1397,12 +1546,12 @@ void spring_update(Spring* this)
 }
 
 
-void add_fall_floor(u8 x, u8 y, u16* map_adr)
+void add_fall_floor(u8 x, u8 y)
 {
 	Fall_Floor* this;
 	for (u8 i = 0; i < MAX_FALL_FLOORS; i++)
 	{
-		this = &(fall_floors[i]);
+		this = &(g->fall_floors[i]);
 		if (!this->obj.active)
 		{
 			init_object(&(this->obj), type_fall_floor, x, y);
@@ -1410,7 +1559,7 @@ void add_fall_floor(u8 x, u8 y, u16* map_adr)
 			this->state = 0;
 			this->solid = true;
 			this->delay = 0;
-			this->map_adr = map_adr;
+			this->map_index = (x >> 3) + (y >> 3)*32;
 
 			this->obj.hitbox.x = -1;
 			this->obj.hitbox.y = -1;
@@ -1422,22 +1571,30 @@ void add_fall_floor(u8 x, u8 y, u16* map_adr)
 	}
 }
 
+//the map holds the fall floor tiles
+static inline void fall_floor_set(Fall_Floor* this, u16 tile)
+{
+	((u16*)MAP_BASE_ADR(4))[this->map_index] = tile;
+}
+
 void fall_floor_update(Fall_Floor* this)
 {
 	//-- idling
 	if (this->state == 0) {
-		if (collide_check(&(this->obj),&(player.obj),0,0))
+		if (collide_check(&(this->obj),&(g->player.obj),0,0))
 			break_fall_floor(this);
 	}
 	//-- shaking
 	else if (this->state == 1) {
 		this->delay -= 1;
-		*(this->map_adr) = 23+(15-this->delay)/5;
+		//-- the tile only changes every 5 frames
+		if (mod5(this->delay) == 0)
+			fall_floor_set(this, 23+div5(15-this->delay));
 		if (this->delay <= 0) {
 			this->state = 2;
 			this->delay = 60; //--how long it hides for
 			this->obj.collideable = false;
-			*(this->map_adr) = 0;
+			fall_floor_set(this, 0);
 		}
 	}
 	//-- invisible, waiting to reset
@@ -1450,48 +1607,59 @@ void fall_floor_update(Fall_Floor* this)
 				psfx(7);
 				this->state = 0;
 				this->obj.collideable = true;
-				*(this->map_adr) = 23;
+				fall_floor_set(this, 23);
 				smoke_init(this->obj.x,this->obj.y);
 			}
 		}
 	}
 }
 
+//the map holds the fall floor tiles, set the one for this state
+void fall_floor_tile(Fall_Floor* this)
+{
+	if (this->state == 0)
+		fall_floor_set(this, 23);
+	else if (this->state == 1)
+		fall_floor_set(this, 23+div5(15-this->delay));
+	else
+		fall_floor_set(this, 0);
+}
+
 void fall_floor_draw(Fall_Floor* this)
 {
-	if (!new_bg)
+	if (!g->new_bg)
 		return;
 
 	if (this->state != 2) {
 		if (this->state != 1)
 			spr(23,this->obj.x,this->obj.y,1,0,0,0);
 		else
-			spr(23+(15-this->delay)/5,this->obj.x,this->obj.y,1,0,0,0);
+			spr(23+div5(15-this->delay),this->obj.x,this->obj.y,1,0,0,0);
 	}
 }
 
 
 void fruit_init(u8 x, u8 y)
 {
-	if (got_fruit[1+level_index()] == true)
+	if (got_fruit(1+level_index()))
 	{
-		fruit.obj.active = false;
+		g->fruit.obj.active = false;
 		return;
 	}
 
-	init_object(&(fruit.obj), type_fruit, x, y);
-	fruit.start = fruit.obj.y;
-	fruit.off = 0;
+	init_object(&(g->fruit.obj), type_fruit, x, y);
+	g->fruit.start = g->fruit.obj.y;
+	g->fruit.off = 0;
 }
 
 void fruit_update(Fruit* this)
 {
-	if (collide_check(&(this->obj), &(player.obj), 0, 0)) {
-		player.djump = max_djump;
-		sfx_timer = 20;
+	if (collide_check(&(this->obj), &(g->player.obj), 0, 0)) {
+		g->player.djump = g->max_djump;
+		g->sfx_timer = 20;
 		sfx(13);
-		got_fruit[1+level_index()] = true;
-		lifeup_init(&lifeup,this->obj.x,this->obj.y);
+		g->fruits |= 1u << (1+level_index());
+		lifeup_init(&g->lifeup,this->obj.x,this->obj.y);
 		this->obj.active = false;
 	}
 	this->off += 1;
@@ -1501,18 +1669,18 @@ void fruit_update(Fruit* this)
 
 void fly_fruit_init(u8 x, u8 y)
 {
-	if (got_fruit[1+level_index()] == true)
+	if (got_fruit(1+level_index()))
 	{
-		fly_fruit.obj.active = false;
+		g->fly_fruit.obj.active = false;
 		return;
 	}
 
-	init_object(&(fly_fruit.obj), type_fly_fruit, x, y);
-	fly_fruit.start = fly_fruit.obj.y;
-	fly_fruit.fly = false;
-	fly_fruit.step = 0.5f;
-	fly_fruit.obj.solids = false;
-	fly_fruit.sfx_delay = 8;
+	init_object(&(g->fly_fruit.obj), type_fly_fruit, x, y);
+	g->fly_fruit.start = g->fly_fruit.obj.y;
+	g->fly_fruit.fly = false;
+	g->fly_fruit.step = 0.5f;
+	g->fly_fruit.obj.solids = false;
+	g->fly_fruit.sfx_delay = 8;
 }
 
 void fly_fruit_update(Fly_Fruit* this)
@@ -1522,7 +1690,7 @@ void fly_fruit_update(Fly_Fruit* this)
 		if (this->sfx_delay > 0) {
 			this->sfx_delay -= 1;
 			if (this->sfx_delay <= 0) {
-				sfx_timer = 20;
+				g->sfx_timer = 20;
 				sfx(14);
 			}
 		}
@@ -1533,19 +1701,19 @@ void fly_fruit_update(Fly_Fruit* this)
 	}
 	//-- wait
 	else {
-		if (has_dashed) {
+		if (g->has_dashed) {
 			this->fly = true;
 		}
 		this->step += 0.05;
 		this->obj.spd.y = sin(this->step) * 0.5;
 	}
 	//-- collect
-	if (collide_check(&(this->obj), &(player.obj), 0, 0)) {
-		player.djump = max_djump;
-		sfx_timer = 20;
+	if (collide_check(&(this->obj), &(g->player.obj), 0, 0)) {
+		g->player.djump = g->max_djump;
+		g->sfx_timer = 20;
 		sfx(13);
-		got_fruit[1+level_index()] = true;
-		lifeup_init(&lifeup,this->obj.x,this->obj.y);
+		g->fruits |= 1u << (1+level_index());
+		lifeup_init(&g->lifeup,this->obj.x,this->obj.y);
 		this->obj.active = false;
 	}
 }
@@ -1560,7 +1728,7 @@ void fly_fruit_draw(Fly_Fruit* this)
 		}
 	}
 	else {
-		off = (int)(off+0.25) % 3;
+		off = mod3(off);
 	}
 	spr(45+off, this->obj.x-6, this->obj.y-2, 1, 0, true, false);
 	spr(this->obj.spr, this->obj.x, this->obj.y, 1, 0, 0, 0);
@@ -1570,53 +1738,53 @@ void fly_fruit_draw(Fly_Fruit* this)
 
 void fake_wall_init(u8 x, u8 y)
 {
-	if (got_fruit[1+level_index()] == true)
+	if (got_fruit(1+level_index()))
 	{
-		fake_wall.active = false;
+		g->fake_wall.active = false;
 		return;
 	}
 
-	init_object(&fake_wall, type_fake_wall, x, y);
+	init_object(&g->fake_wall, type_fake_wall, x, y);
 
-	fake_wall.hitbox.x = 0;
-	fake_wall.hitbox.y = 0;
-	fake_wall.hitbox.w = 16;
-	fake_wall.hitbox.h = 16;
+	g->fake_wall.hitbox.x = 0;
+	g->fake_wall.hitbox.y = 0;
+	g->fake_wall.hitbox.w = 16;
+	g->fake_wall.hitbox.h = 16;
 }
 
 void fake_wall_update()
 {
-	if (player.dash_effect_time > 0) {
+	if (g->player.dash_effect_time > 0) {
 
-		fake_wall.hitbox.x = -1;
-		fake_wall.hitbox.y = -1;
-		fake_wall.hitbox.w = 18;
-		fake_wall.hitbox.h = 18;
+		g->fake_wall.hitbox.x = -1;
+		g->fake_wall.hitbox.y = -1;
+		g->fake_wall.hitbox.w = 18;
+		g->fake_wall.hitbox.h = 18;
 
-		if (collide_check(&fake_wall, &(player.obj), 0, 0)) {
-			player.obj.spd.x = -sign(player.obj.spd.x)*1.5;
-			player.obj.spd.y = -1.5;
-			player.dash_time = 0;
-			sfx_timer = 20;
+		if (collide_check(&g->fake_wall, &(g->player.obj), 0, 0)) {
+			g->player.obj.spd.x = -sign(g->player.obj.spd.x)*1.5;
+			g->player.obj.spd.y = -1.5;
+			g->player.dash_time = 0;
+			g->sfx_timer = 20;
 			sfx(16);
-			fake_wall.active = false;
-			smoke_init(fake_wall.x, fake_wall.y);
-			smoke_init(fake_wall.x+8, fake_wall.y);
-			smoke_init(fake_wall.x, fake_wall.y+8);
-			smoke_init(fake_wall.x+4, fake_wall.y+4);
-			fruit_init(fake_wall.x+4, fake_wall.y+4);
+			g->fake_wall.active = false;
+			smoke_init(g->fake_wall.x, g->fake_wall.y);
+			smoke_init(g->fake_wall.x+8, g->fake_wall.y);
+			smoke_init(g->fake_wall.x, g->fake_wall.y+8);
+			smoke_init(g->fake_wall.x+4, g->fake_wall.y+4);
+			fruit_init(g->fake_wall.x+4, g->fake_wall.y+4);
 		}
 
-		fake_wall.hitbox.x = 0;
-		fake_wall.hitbox.y = 0;
-		fake_wall.hitbox.w = 16;
-		fake_wall.hitbox.h = 16;
+		g->fake_wall.hitbox.x = 0;
+		g->fake_wall.hitbox.y = 0;
+		g->fake_wall.hitbox.w = 16;
+		g->fake_wall.hitbox.h = 16;
 	}
 }
 
 void fake_wall_draw()
 {
-	Object* this = &fake_wall;
+	Object* this = &g->fake_wall;
 	spr(64, this->x, this->y, 1, 0, 0, 0);
 	spr(65, this->x+8, this->y, 1, 0, 0, 0);
 	spr(80, this->x, this->y+8, 1, 0, 0, 0);
@@ -1626,44 +1794,44 @@ void fake_wall_draw()
 
 void flag_init(u8 x, u8 y)
 {
-	init_object(&(flag.obj), type_flag, x + 5, y);
-	flag.score = 0;
-	flag.show = false;
+	init_object(&(g->landmark.flag.obj), type_flag, x + 5, y);
+	g->landmark.flag.score = 0;
+	g->landmark.flag.show = false;
 
 	for (u8 i = 0; i < 32; i++)
 	{
-		if (got_fruit[i])
-			flag.score += 1;
+		if (got_fruit(i))
+			g->landmark.flag.score += 1;
 	}
 }
 
 void flag_draw(Flag* this)
 {
 	//summit curtains
-	if (player.obj.active)
+	if (g->player.obj.active)
 	{
-		u8 diff = player.obj.x;
-		if (player.obj.x > 64)
-			diff = 128 - player.obj.x;
+		u8 diff = g->player.obj.x;
+		if (g->player.obj.x > 64)
+			diff = 128 - g->player.obj.x;
 		
 		if (diff > 36)
 		{
-			rectfill(0,0,3,16,0);
-			rectfill(13,0,3,16,0);
+			winfill(0,0,3,16,0);
+			winfill(13,0,3,16,0);
 		}
 		else if (diff > 24)
 		{
-			rectfill(0,0,2,16,0);
-			rectfill(14,0,2,16,0);
+			winfill(0,0,2,16,0);
+			winfill(14,0,2,16,0);
 		}
 		else if (diff > 12)
 		{
-			rectfill(0,0,1,16,0);
-			rectfill(15,0,1,16,0);
+			winfill(0,0,1,16,0);
+			winfill(15,0,1,16,0);
 		}
 	}
 
-	this->obj.spr = 118 + (frames/5) % 3;
+	this->obj.spr = 118 + mod3(div5(g->frames));
 	spr(this->obj.spr,this->obj.x,this->obj.y,2,0,0,0);
 	if (this->show) {
 		rectfill(4,1,8,4,0);
@@ -1673,12 +1841,12 @@ void flag_draw(Flag* this)
 			char str[8] = "x  ";
 			if (this->score < 10)
 			{
-				str[1] = (this->score%10) + '0';
+				str[1] = this->score + '0';
 			}
 			else
 			{
-				str[1] = (this->score/10) + '0';
-				str[2] = (this->score%10) + '0';
+				str[1] = div10(this->score) + '0';
+				str[2] = mod10(this->score) + '0';
 			}
 			print(str,64-4,9+6,7);
 		}
@@ -1689,7 +1857,7 @@ void flag_draw(Flag* this)
 			char str[16] = "deaths:9999";
 			s8 xoff = 4;
 			
-			if (cheated)
+			if (g->cheated)
 			{
 				str[0] = 'c';
 				str[1] = 'h';
@@ -1700,29 +1868,27 @@ void flag_draw(Flag* this)
 				str[6] = 'r';
 			}
 
-			if (deaths < 9999)
+			if (g->deaths < 9999)
 			{
-				u16 temp = deaths;
-
-				u8 thousands = temp/1000;
-				temp -= thousands * 1000;
+				u16 temp = g->deaths;
 
-				u8 hundreds = temp/100;
-				temp -= hundreds * 100;
+				u8 ones = mod10(temp);
+				temp = div10(temp);
 
-				u8 tens = temp/10;
-				temp -= tens * 10;
+				u8 tens = mod10(temp);
+				temp = div10(temp);
 
-				u8 ones = temp%10;
+				u8 hundreds = mod10(temp);
+				u8 thousands = div10(temp);
 
-				if (deaths >= 1000)
+				if (g->deaths >= 1000)
 				{
 					str[7] = thousands + '0';
 					str[8] = hundreds + '0';
 					str[9] = tens + '0';
 					str[10] = ones + '0';
 				}
-				else if (deaths >= 100)
+				else if (g->deaths >= 100)
 				{
 					str[7] = hundreds + '0';
 					str[8] = tens + '0';
@@ -1730,7 +1896,7 @@ void flag_draw(Flag* this)
 					str[10] = '\0';
 					xoff = 2;
 				}
-				else if (deaths >= 10)
+				else if (g->deaths >= 10)
 				{
 					str[7] = tens + '0';
 					str[8] = ones + '0';
@@ -1751,9 +1917,9 @@ void flag_draw(Flag* this)
 		if (btnp(KEY_START))
 			title_screen();
 	}
-	else if (collide_check(&(this->obj),&(player.obj),0,0)) {
+	else if (collide_check(&(this->obj),&(g->player.obj),0,0)) {
 		sfx(55);
-		sfx_timer = 30;
+		g->sfx_timer = 30;
 		this->show = true;
 	}
 }
@@ -1761,25 +1927,25 @@ void flag_draw(Flag* this)
 
 void chest_init(u8 x, u8 y)
 {
-	if (got_fruit[1+level_index()] == true)
+	if (got_fruit(1+level_index()))
 	{
-		chest.obj.active = false;
+		g->chest.obj.active = false;
 		return;
 	}
 
-	init_object(&(chest.obj), type_chest, x, y);
-	chest.start = chest.obj.x;
-	chest.timer = 20;
+	init_object(&(g->chest.obj), type_chest, x, y);
+	g->chest.start = g->chest.obj.x;
+	g->chest.timer = 20;
 }
 
 void chest_update(Chest* this)
 {
-	if (has_key) {
+	if (g->has_key) {
 		if (this->timer > 0)
 			this->timer -= 1;
 		this->obj.x = this->start-1+rnd(3);
 		if (this->timer <= 0) {
-			sfx_timer = 20;
+			g->sfx_timer = 20;
 			sfx(16);
 			fruit_init(this->obj.x, this->obj.y-4);
 			this->obj.active = false;
@@ -1791,24 +1957,24 @@ void chest_update(Chest* this)
 void key_update(Object* this)
 {
 	u8 was = flr(this->spd.x);
-	this->spd.x = 9+(sin(frames/30.f)+0.5)*1;
+	this->spd.x = 9+(sin(frame_turns[g->frames])+0.5)*1;
 	u8 is = flr(this->spd.x);
 	this->spr = is;
 	if (is == 10 && is != was) {
 		this->flip.x = !this->flip.x;
 	}
-	if (collide_check(this, &(player.obj), 0, 0)) {
+	if (collide_check(this, &(g->player.obj), 0, 0)) {
 		sfx(23);
-		sfx_timer = 10;
+		g->sfx_timer = 10;
 		this->active = false;
-		has_key = true;
+		g->has_key = true;
 	}
 }
 
 
 void message_init(u8 x, u8 y)
 {
-	Message* this = &message;
+	Message* this = &g->landmark.message;
 
 	init_object(&(this->obj), type_message, x, y);
 	this->index = 0;
@@ -1819,9 +1985,9 @@ void message_init(u8 x, u8 y)
 void message_draw(Message* this)
 {
 	char text[] = "-- celeste mountain --#this memorial to those# perished on the climb";
-	if (collide_check(&(this->obj), &(player.obj), 4, 0)) {
+	if (collide_check(&(this->obj), &(g->player.obj), 4, 0)) {
 		if (text[this->index] != '\0') {
-			if (frames%2 == 0)
+			if (g->frames%2 == 0)
 			{
 				this->index += 1;
 				this->len += 1;
@@ -1832,7 +1998,7 @@ void message_draw(Message* this)
 				}
 			}
 
-			if (frames%3 == 0)
+			if (mod3(g->frames) == 0)
 				sfx(35);
 		}
 
@@ -1856,7 +2022,7 @@ void add_platform(u8 x, u8 y, s8 dir)
 	Platform* this;
 	for (u8 i = 0; i < MAX_PLATFORMS; i++)
 	{
-		this = &(platforms[i]);
+		this = &(g->platforms[i]);
 
 		if (!this->obj.active)
 		{
@@ -1880,11 +2046,11 @@ void platform_update(Platform* this)
 	else if (this->obj.x > 128) { this->obj.x = -16; }
 
 	if (flr(this->last) != flr(this->obj.x)) {
-		if (player.obj.spd.y < 0 || player.obj.y != this->obj.y - 8 ||
-			player.obj.x + player.obj.hitbox.x >= this->obj.x + 16 || player.obj.x + player.obj.hitbox.x + player.obj.hitbox.w <= this->obj.x)
+		if (g->player.obj.spd.y < 0 || g->player.obj.y != this->obj.y - 8 ||
+			g->player.obj.x + g->player.obj.hitbox.x >= this->obj.x + 16 || g->player.obj.x + g->player.obj.hitbox.x + g->player.obj.hitbox.w <= this->obj.x)
 		{}
 		else {
-			move_x(&(player.obj), flr(this->obj.x)-flr(this->last),1);
+			move_x(&(g->player.obj), flr(this->obj.x)-flr(this->last),1);
 		}
 	}
 
@@ -1915,20 +2081,20 @@ void room_title_draw(Room_Title* this)
 		//rectfill(1,1,5,1,0);
 		rectfill(3,7,10,2,0);
 
-		if (room.x == 3 && room.y == 1) {
+		if (g->room.x == 3 && g->room.y == 1) {
 			print("old site",48,62,7);
 		} else if (level_index() == 30) {
 			print("summit",52,62,7);
 		} else {
 			char str[8] = " 000 m";
-			u16 level = (1+level_index())*100;
+			u8 level = 1+level_index();
 
-			if (level >= 1000)
-				str[0] = (level / 1000) + '0';
+			if (level >= 10)
+				str[0] = div10(level) + '0';
 
-			str[1] = ((level % 1000) / 100) + '0';
+			str[1] = mod10(level) + '0';
 
-			print(str,52-((level<1000)? 2 : 0),62,7);
+			print(str,52-((level<10)? 2 : 0),62,7);
 		}
 
 		draw_time(4+4,4+4);
@@ -1938,6 +2104,9 @@ void room_title_draw(Room_Title* this)
 		spr(141, 28, 8, 0, PAL_OVERLAY, 0, 0);
 		spr(141, 36, 8, 0, PAL_OVERLAY, 0, 0);
 		spr(141, 37, 8, 0, PAL_OVERLAY, 0, 0);
+
+		//last room against its best
+		draw_delta(4+4,4+4+6);
 	}
 }
 
@@ -1946,47 +2115,45 @@ void room_title_draw(Room_Title* this)
 //--------------------
 void restart_room()
 {
-	will_restart = true;
-	delay_restart = 15;
+	g->will_restart = true;
+	g->delay_restart = 15;
 }
 
 void load_room(u8 x, u8 y)
 {
-	has_dashed = false;
-	has_key = false;
+	g->has_dashed = false;
+	g->has_key = false;
 
 	//--remove existing objects
-	player.obj.active = false;
-	fake_wall.active = false;
-	key.active = false;
-	chest.obj.active = false;
-	fruit.obj.active = false;
-	fly_fruit.obj.active = false;
-	lifeup.obj.active = false;
-	room_title.active = false;
-	big_chest.obj.active = false;
-	orb.obj.active = false;
-	flag.obj.active = false;
-	message.obj.active = false;
-
-	for (u8 i = 0; i < MAX_SMOKE; i++)
-		smoke[i].active = false;
+	g->player.obj.active = false;
+	g->fake_wall.active = false;
+	g->key.active = false;
+	g->chest.obj.active = false;
+	g->fruit.obj.active = false;
+	g->fly_fruit.obj.active = false;
+	g->lifeup.obj.active = false;
+	g->room_title.active = false;
+	g->landmark.obj.active = false;
+	g->orb.obj.active = false;
+
+	fx_clear(fx_smoke);
+	fx_clear(fx_chest);
 
 	for (u8 i = 0; i < MAX_FALL_FLOORS; i++)
-		fall_floors[i].obj.active = false;
+		g->fall_floors[i].obj.active = false;
 
 	for (u8 i = 0; i < MAX_SPRINGS; i++)
-		springs[i].obj.active = false;
+		g->springs[i].obj.active = false;
 
 	for (u8 i = 0; i < MAX_BALLOONS; i++)
-		balloons[i].obj.active = false;
+		g->balloons[i].obj.active = false;
 
 	for (u8 i = 0; i < MAX_PLATFORMS; i++)
-		platforms[i].obj.active = false;
+		g->platforms[i].obj.active = false;
 
 	//--current room
-	room.x = x;
-	room.y = y;
+	g->room.x = x;
+	g->room.y = y;
 
 	//-- entities
 	u32 i = level_index() * 16 * 16;
@@ -2017,8 +2184,8 @@ void load_room(u8 x, u8 y)
 
 				case type_key:
 				{
-					if (!got_fruit[1+level_index()])
-						init_object(&key, type_key, tx*8, ty*8);
+					if (!got_fruit(1+level_index()))
+						init_object(&g->key, type_key, tx*8, ty*8);
 				}
 				break;
 
@@ -2035,11 +2202,11 @@ void load_room(u8 x, u8 y)
 					break;
 
 				case type_player_spawn:
-					player_spawn_init(&player_spawn, tx, ty);
+					player_spawn_init(&g->player_spawn, tx, ty);
 					break;
 
 				case type_fall_floor:
-					add_fall_floor(tx*8, ty*8, map_adr);
+					add_fall_floor(tx*8, ty*8);
 					*map_adr = tile;
 					break;
 
@@ -2085,26 +2252,688 @@ void load_room(u8 x, u8 y)
 
 	if (!is_title())
 	{
-		room_title_init(&room_title);
+		room_title_init(&g->room_title);
 	}
 }
 
 void next_room()
 {
-	if (room.x == 2 && room.y == 1) {
+	end_split();
+
+	if (g->room.x == 2 && g->room.y == 1) {
 		music(30,500,7);
-	} else if (room.x == 3 && room.y == 1) {
+	} else if (g->room.x == 3 && g->room.y == 1) {
 		music(20,500,7);
-	} else if (room.x == 4 && room.y == 2) {
+	} else if (g->room.x == 4 && g->room.y == 2) {
 		music(30,500,7);
-	} else if (room.x == 5 && room.y == 3) {
+	} else if (g->room.x == 5 && g->room.y == 3) {
 		music(30,500,7);
 	}
 
-	if (room.x == 7)
-		load_room(0,room.y+1);
+	if (g->room.x == 7)
+		load_room(0,g->room.y+1);
 	else
-		load_room(room.x+1,room.y);
+		load_room(g->room.x+1,g->room.y);
+}
+
+
+//-- savestates --
+//----------------
+//compact little endian snapshot of the whole simulation in sram:
+//header (magic, version, payload length, crc) followed by the payload
+#define SAVESTATE_SRAM 0x0000
+#define SAVESTATE_MAGIC 0x53434343	//"CCCS"
+#define SAVESTATE_VERSION 5
+#define SAVESTATE_SIZE 4096	//worst case with every pool full is ~3.6k
+
+typedef struct
+{
+	u32 magic;
+	u8 version;
+	u8 pad;
+	u16 len;
+	u16 crc;
+	u16 pad2;
+} Savestate_Header;
+
+static THREAD_LOCAL u8 savestate[SAVESTATE_SIZE] EWRAM_BSS;
+static THREAD_LOCAL u8* sp;
+
+//crc-16/ccitt
+static const u16 crc_table[256] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+	0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+	0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+	0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+	0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+	0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+	0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+	0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+	0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+	0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+	0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+	0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+	0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+	0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+	0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+	0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+	0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+	0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+	0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+	0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+	0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+	0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+	0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+	0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+	0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+	0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+	0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+	0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+	0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+	0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+	0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+static u16 crc16(const u8* data, u16 len)
+{
+	u16 crc = 0xFFFF;
+	for (u16 i = 0; i < len; i++)
+		crc = (crc << 8) ^ crc_table[(crc >> 8) ^ data[i]];
+	return crc;
+}
+
+static void w8(u8 v) { *sp++ = v; }
+static void w16(u16 v) { w8(v); w8(v >> 8); }
+static void w32(u32 v) { w16(v); w16(v >> 16); }
+static void wf(float v) { u32 u; memcpy(&u, &v, 4); w32(u); }
+
+static u8 r8() { return *sp++; }
+static u16 r16() { u16 v = r8(); return v | (r8() << 8); }
+static u32 r32() { u32 v = r16(); return v | (r16() << 16); }
+static float rf() { u32 u = r32(); float v; memcpy(&v, &u, 4); return v; }
+
+//inactive objects are a single byte, except the player
+//who can still be collided with after dying
+static bool save_object(Object* obj)
+{
+	w8(obj->active | (obj->collideable << 1) | (obj->solids << 2) | (obj->flip.x << 3) | (obj->flip.y << 4));
+	if (!obj->active && obj != &(g->player.obj))
+		return false;
+
+	w8(obj->type);
+	w8(obj->spr);
+	wf(obj->x);
+	wf(obj->y);
+	w8(obj->hitbox.x);
+	w8(obj->hitbox.y);
+	w8(obj->hitbox.w);
+	w8(obj->hitbox.h);
+	wf(obj->spd.x);
+	wf(obj->spd.y);
+	wf(obj->rem.x);
+	wf(obj->rem.y);
+	return obj->active;
+}
+
+static bool load_object(Object* obj)
+{
+	u8 bits = r8();
+	obj->active = bits & 1;
+	obj->collideable = (bits >> 1) & 1;
+	obj->solids = (bits >> 2) & 1;
+	obj->flip.x = (bits >> 3) & 1;
+	obj->flip.y = (bits >> 4) & 1;
+	if (!obj->active && obj != &(g->player.obj))
+		return false;
+
+	obj->type = r8();
+	obj->spr = r8();
+	obj->x = rf();
+	obj->y = rf();
+	obj->hitbox.x = (s8)r8();
+	obj->hitbox.y = (s8)r8();
+	obj->hitbox.w = r8();
+	obj->hitbox.h = r8();
+	obj->spd.x = rf();
+	obj->spd.y = rf();
+	obj->rem.x = rf();
+	obj->rem.y = rf();
+	return obj->active;
+}
+
+static void save_payload()
+{
+	//-- room first, restoring reloads it before the objects
+	w8(g->room.x);
+	w8(g->room.y);
+
+	w32(g->fruits);
+
+	w8(g->freeze);
+	w8(g->shake);
+	w8(g->cheated | (g->will_restart << 1) | (g->has_dashed << 2) | (g->has_key << 3) |
+		(g->pause_player << 4) | (g->flash_bg << 5) | (g->start_game << 6) | (g->new_bg << 7));
+	w8(g->delay_restart);
+	w8(g->sfx_timer);
+	w8(g->music_timer);
+	w8(g->frames);
+	w8(g->seconds);
+	w8(g->minutes);
+	w32(g->run_frames);
+	w32(g->room_start);
+	w8(g->max_djump);
+	w16(g->start_game_flash);
+	w16(g->deaths);
+	w32(rnd_seed);
+	w8(current_music());
+
+	//-- player
+	save_object(&g->player.obj);
+	w8(g->player.p_jump | (g->player.p_dash << 1) | (g->player.was_on_ground << 2));
+	w8(g->player.grace);
+	w8(g->player.jbuffer);
+	w8(g->player.djump);
+	w8(g->player.dash_time);
+	w8(g->player.dash_effect_time);
+	w8(g->player.spr_off);
+	wf(g->player.dash_target.x);
+	wf(g->player.dash_target.y);
+	wf(g->player.dash_accel.x);
+	wf(g->player.dash_accel.y);
+
+	w8(g->player_spawn.active | (g->player_spawn.solids << 1) | (g->player_spawn.flip.x << 2) | (g->player_spawn.flip.y << 3));
+	w16(g->player_spawn.x);
+	w16(g->player_spawn.y);
+	w8(g->player_spawn.spr);
+	w8(g->player_spawn.target.x);
+	w8(g->player_spawn.target.y);
+	wf(g->player_spawn.spd.x);
+	wf(g->player_spawn.spd.y);
+	w8(g->player_spawn.state);
+	w8(g->player_spawn.delay);
+
+	for (u8 i = 0; i < MAX_HAIR; i++)
+	{
+		w32(g->hair_x[i]);
+		w32(g->hair_y[i]);
+	}
+
+	//-- single objects
+	save_object(&g->key);
+	save_object(&g->fake_wall);
+	save_object(&g->orb.obj);
+
+	save_object(&g->chest.obj);
+	w8(g->chest.start);
+	w8(g->chest.timer);
+
+	save_object(&g->fruit.obj);
+	w8(g->fruit.start);
+	w8(g->fruit.off);
+
+	save_object(&g->fly_fruit.obj);
+	w8(g->fly_fruit.start);
+	w8(g->fly_fruit.fly);
+	wf(g->fly_fruit.step);
+	w8(g->fly_fruit.sfx_delay);
+
+	save_object(&g->lifeup.obj);
+	w8(g->lifeup.duration);
+	w8(g->lifeup.flash);
+
+	w8(g->room_title.active);
+	w8(g->room_title.delay);
+
+	//-- the landmark, whichever one the room has
+	if (save_object(&g->landmark.obj))
+	{
+		switch (g->landmark.obj.type)
+		{
+			case type_big_chest:
+				w8(g->landmark.big_chest.state);
+				w8(g->landmark.big_chest.timer);
+				break;
+			case type_flag:
+				w8(g->landmark.flag.score);
+				w8(g->landmark.flag.show);
+				break;
+			case type_message:
+				w8(g->landmark.message.index);
+				w8(g->landmark.message.lines);
+				w8(g->landmark.message.len);
+				break;
+		}
+	}
+
+	//-- object lists
+	for (u8 i = 0; i < MAX_BALLOONS; i++)
+	{
+		Balloon* this = &(g->balloons[i]);
+		save_object(&(this->obj));
+		wf(this->offset);
+		wf(this->start);
+		w8(this->timer);
+	}
+
+	for (u8 i = 0; i < MAX_FALL_FLOORS; i++)
+	{
+		Fall_Floor* this = &(g->fall_floors[i]);
+		save_object(&(this->obj));
+		w8(this->state);
+		w8(this->solid);
+		w8(this->delay);
+		w16(this->map_index);
+	}
+
+	for (u8 i = 0; i < MAX_PLATFORMS; i++)
+	{
+		save_object(&(g->platforms[i].obj));
+		wf(g->platforms[i].last);
+	}
+
+	for (u8 i = 0; i < MAX_SPRINGS; i++)
+	{
+		Spring* this = &(g->springs[i]);
+		save_object(&(this->obj));
+		w8(this->hide_in);
+		w8(this->hide_for);
+		w8(this->delay);
+	}
+
+	//-- particles, each kind front to back
+	for (u8 kind = 0; kind < FX_KINDS; kind++)
+	{
+		w8(g->fx.count[kind]);
+		for (u8 i = g->fx.head[kind]; i != 0; i = g->fx.next[i])
+		{
+			w32(g->fx.x[i]);
+			w32(g->fx.y[i]);
+			w16(g->fx.dx[i]);
+			w16(g->fx.dy[i]);
+			w16(g->fx.phase[i]);
+			w8(g->fx.spr[i]);
+			w8(g->fx.t[i]);
+			w8(g->fx.flip[i]);
+		}
+	}
+}
+
+static void load_payload()
+{
+	//-- rebuild the room map, then overwrite its objects
+	u8 x = r8();
+	u8 y = r8();
+
+	g->fruits = r32();
+
+	load_room(x, y);
+
+	g->freeze = r8();
+	g->shake = r8();
+	u8 bits = r8();
+	g->cheated = bits & 1;
+	g->will_restart = (bits >> 1) & 1;
+	g->has_dashed = (bits >> 2) & 1;
+	g->has_key = (bits >> 3) & 1;
+	g->pause_player = (bits >> 4) & 1;
+	g->flash_bg = (bits >> 5) & 1;
+	g->start_game = (bits >> 6) & 1;
+	g->new_bg = (bits >> 7) & 1;
+	g->delay_restart = r8();
+	g->sfx_timer = r8();
+	g->music_timer = r8();
+	g->frames = r8();
+	g->seconds = r8();
+	g->minutes = r8();
+	g->run_frames = r32();
+	g->room_start = r32();
+	g->max_djump = r8();
+	g->start_game_flash = r16();
+	g->deaths = r16();
+	rnd_seed = r32();
+	s8 track = r8();
+
+	//-- player
+	load_object(&g->player.obj);
+	bits = r8();
+	g->player.p_jump = bits & 1;
+	g->player.p_dash = (bits >> 1) & 1;
+	g->player.was_on_ground = (bits >> 2) & 1;
+	g->player.grace = r8();
+	g->player.jbuffer = r8();
+	g->player.djump = r8();
+	g->player.dash_time = r8();
+	g->player.dash_effect_time = r8();
+	g->player.spr_off = r8();
+	g->player.dash_target.x = rf();
+	g->player.dash_target.y = rf();
+	g->player.dash_accel.x = rf();
+	g->player.dash_accel.y = rf();
+
+	bits = r8();
+	g->player_spawn.active = bits & 1;
+	g->player_spawn.solids = (bits >> 1) & 1;
+	g->player_spawn.flip.x = (bits >> 2) & 1;
+	g->player_spawn.flip.y = (bits >> 3) & 1;
+	g->player_spawn.x = r16();
+	g->player_spawn.y = r16();
+	g->player_spawn.spr = r8();
+	g->player_spawn.target.x = r8();
+	g->player_spawn.target.y = r8();
+	g->player_spawn.spd.x = rf();
+	g->player_spawn.spd.y = rf();
+	g->player_spawn.state = r8();
+	g->player_spawn.delay = r8();
+
+	for (u8 i = 0; i < MAX_HAIR; i++)
+	{
+		g->hair_x[i] = r32();
+		g->hair_y[i] = r32();
+	}
+
+	//-- single objects
+	load_object(&g->key);
+	load_object(&g->fake_wall);
+	load_object(&g->orb.obj);
+
+	load_object(&g->chest.obj);
+	g->chest.start = r8();
+	g->chest.timer = r8();
+
+	load_object(&g->fruit.obj);
+	g->fruit.start = r8();
+	g->fruit.off = r8();
+
+	load_object(&g->fly_fruit.obj);
+	g->fly_fruit.start = r8();
+	g->fly_fruit.fly = r8();
+	g->fly_fruit.step = rf();
+	g->fly_fruit.sfx_delay = r8();
+
+	load_object(&g->lifeup.obj);
+	g->lifeup.duration = r8();
+	g->lifeup.flash = r8();
+
+	g->room_title.active = r8();
+	g->room_title.delay = r8();
+
+	//-- the landmark
+	if (load_object(&g->landmark.obj))
+	{
+		switch (g->landmark.obj.type)
+		{
+			case type_big_chest:
+				g->landmark.big_chest.state = r8();
+				g->landmark.big_chest.timer = r8();
+				break;
+			case type_flag:
+				g->landmark.flag.score = r8();
+				g->landmark.flag.show = r8();
+				break;
+			case type_message:
+				g->landmark.message.index = r8();
+				g->landmark.message.lines = r8();
+				g->landmark.message.len = r8();
+				break;
+		}
+	}
+
+	//-- object lists
+	for (u8 i = 0; i < MAX_BALLOONS; i++)
+	{
+		Balloon* this = &(g->balloons[i]);
+		load_object(&(this->obj));
+		this->offset = rf();
+		this->start = rf();
+		this->timer = r8();
+	}
+
+	for (u8 i = 0; i < MAX_FALL_FLOORS; i++)
+	{
+		Fall_Floor* this = &(g->fall_floors[i]);
+		load_object(&(this->obj));
+		this->state = r8();
+		this->solid = r8();
+		this->delay = r8();
+		this->map_index = r16();
+
+		if (this->obj.active)
+			fall_floor_tile(this);
+	}
+
+	for (u8 i = 0; i < MAX_PLATFORMS; i++)
+	{
+		load_object(&(g->platforms[i].obj));
+		g->platforms[i].last = rf();
+	}
+
+	for (u8 i = 0; i < MAX_SPRINGS; i++)
+	{
+		Spring* this = &(g->springs[i]);
+		load_object(&(this->obj));
+		this->hide_in = r8();
+		this->hide_for = r8();
+		this->delay = r8();
+	}
+
+	//-- particles, fx_new() builds each list back to front so turn it around.
+	//slot 0 soaks up any that don't fit
+	fx_reset();
+	for (u8 kind = 0; kind < FX_KINDS; kind++)
+	{
+		u8 n = r8();
+		for (u8 j = 0; j < n; j++)
+		{
+			u8 i = fx_new(kind);
+			g->fx.x[i] = r32();
+			g->fx.y[i] = r32();
+			g->fx.dx[i] = r16();
+			g->fx.dy[i] = r16();
+			g->fx.phase[i] = r16();
+			g->fx.spr[i] = r8();
+			g->fx.t[i] = r8();
+			g->fx.flip[i] = r8();
+		}
+
+		u8 prev = 0;
+		for (u8 i = g->fx.head[kind], next; i != 0; i = next)
+		{
+			next = g->fx.next[i];
+			g->fx.next[i] = prev;
+			prev = i;
+		}
+		g->fx.head[kind] = prev;
+	}
+
+	//-- no spawn sound from reloading the room, keep the music going
+	mmEffectCancelAll();
+	if (track != current_music())
+		music(track,0,7);
+}
+
+void save_state()
+{
+	sp = savestate;
+	save_payload();
+
+	Savestate_Header header = { 0 };
+	header.magic = SAVESTATE_MAGIC;
+	header.version = SAVESTATE_VERSION;
+	header.len = sp - savestate;
+	header.crc = crc16(savestate, header.len);
+
+	//header last, an interrupted save leaves the old one invalid rather than half written
+	sram_write(SAVESTATE_SRAM + sizeof(header), savestate, header.len);
+	sram_write(SAVESTATE_SRAM, &header, sizeof(header));
+}
+
+bool load_state()
+{
+	Savestate_Header header;
+	sram_read(SAVESTATE_SRAM, &header, sizeof(header));
+
+	if (header.magic != SAVESTATE_MAGIC || header.version != SAVESTATE_VERSION || header.len > SAVESTATE_SIZE)
+		return false;
+
+	sram_read(SAVESTATE_SRAM + sizeof(header), savestate, header.len);
+	if (crc16(savestate, header.len) != header.crc)
+		return false;
+
+	sp = savestate;
+	load_payload();
+	format_time();
+	g->practice = true;
+	return true;
+}
+
+
+//-- speedrun splits --
+//---------------------
+//time spent in each room (frames), best ones are kept in sram
+#define SPLITS_SRAM 0x1100
+#define SPLITS_MAGIC 0x54505343	//"CSPT"
+#define SPLITS_VERSION 2
+#define SPLITS 30	//the timer stops at the summit
+
+typedef struct
+{
+	u32 magic;
+	u8 version;
+	u8 pad;
+	u16 crc;	//of best and current
+	u32 best[SPLITS];	//0 when the room has no best yet
+	u32 current[SPLITS];	//of the run being played, or the last one
+} Splits_Save;
+
+//touched when a room is finished, so they live in ewram
+static THREAD_LOCAL Splits_Save splits EWRAM_BSS;
+
+//delta of the last room against its best, shown with the next room title
+static THREAD_LOCAL char delta_str[8] = "";
+static THREAD_LOCAL u8 delta_col = 7;
+
+//frames to hundredths of a second
+static const u8 frame_hundredths[30] = {
+	 0,  3,  7, 10, 13, 17, 20, 23, 27, 30,
+	33, 37, 40, 43, 47, 50, 53, 57, 60, 63,
+	67, 70, 73, 77, 80, 83, 87, 90, 93, 97
+};
+
+static void save_splits()
+{
+	splits.crc = crc16((u8*)splits.best, sizeof(splits.best)+sizeof(splits.current));
+	sram_write(SPLITS_SRAM, &splits, sizeof(splits));
+}
+
+void load_splits()
+{
+	sram_read(SPLITS_SRAM, &splits, sizeof(splits));
+
+	//version 1 kept only the bests
+	if (splits.magic == SPLITS_MAGIC && splits.version == 1 &&
+		splits.crc == crc16((u8*)splits.best, sizeof(splits.best)))
+	{
+		memset(splits.current, 0, sizeof(splits.current));
+		splits.version = SPLITS_VERSION;
+		save_splits();
+	}
+
+	if (splits.magic != SPLITS_MAGIC || splits.version != SPLITS_VERSION ||
+		splits.crc != crc16((u8*)splits.best, sizeof(splits.best)+sizeof(splits.current)))
+	{
+		memset(&splits, 0, sizeof(splits));
+		splits.magic = SPLITS_MAGIC;
+		splits.version = SPLITS_VERSION;
+	}
+}
+
+//"+s.hh" or "-s.hh", formatted once per room
+static void format_delta(s32 delta)
+{
+	u8 i = 0;
+	u32 d = abs(delta);
+	u32 secs = d / 30;
+	u8 hundredths = frame_hundredths[d % 30];
+
+	//three digits of seconds fit the box, longer deltas show as 999.99
+	if (secs > 999)
+	{
+		secs = 999;
+		hundredths = 99;
+	}
+
+	delta_str[i++] = (delta < 0)? '-': '+';
+	if (secs >= 100)
+		delta_str[i++] = '0' + secs/100;
+	if (secs >= 10)
+		delta_str[i++] = '0' + (secs/10)%10;
+	delta_str[i++] = '0' + secs%10;
+	delta_str[i++] = '.';
+	delta_str[i++] = '0' + hundredths/10;
+	delta_str[i++] = '0' + hundredths%10;
+	delta_str[i] = '\0';
+
+	delta_col = (delta < 0)? 11: (delta > 0)? 8: 7;
+}
+
+//called when leaving a room
+void end_split()
+{
+	u8 level = level_index();
+	u32 time = g->run_frames - g->room_start;
+	g->room_start = g->run_frames;
+
+	delta_str[0] = '\0';
+	if (level >= SPLITS)
+		return;
+
+	splits.current[level] = time;
+
+	if (splits.best[level] != 0)
+		format_delta((s32)time - (s32)splits.best[level]);
+
+	if (!g->cheated && !g->practice && (splits.best[level] == 0 || time < splits.best[level]))
+		splits.best[level] = time;
+
+	//the summit shows the whole run against the sum of the bests, the time
+	//there was still to gain. only when every room was played this run.
+	if (level == SPLITS-1)
+	{
+		s32 lost = 0;
+		for (u8 i = 0; i < SPLITS; i++)
+		{
+			if (splits.current[i] == 0 || splits.best[i] == 0)
+				break;
+			lost += (s32)splits.current[i] - (s32)splits.best[i];
+			if (i == SPLITS-1)
+				format_delta(lost);
+		}
+	}
+
+	save_splits();
+}
+
+//a new run has no room times yet
+void start_splits()
+{
+	memset(splits.current, 0, sizeof(splits.current));
+	save_splits();
+}
+
+void draw_delta(u8 x, u8 y)
+{
+	if (delta_str[0] == '\0')
+		return;
+
+	//its own text palette, the room name and clock stay white
+	print2(delta_str,x+1,y+1,delta_col);
+
+	//black rectangle behind delta, after the text so it stays below it
+	spr(141, x+4, y, 0, PAL_OVERLAY, 0, 0);
+	spr(141, x+12, y, 0, PAL_OVERLAY, 0, 0);
+	spr(141, x+20, y, 0, PAL_OVERLAY, 0, 0);
+	spr(141, x+24, y, 0, PAL_OVERLAY, 0, 0);
 }
 
 
@@ -2112,77 +2941,88 @@ void next_room()
 //---------------------
 void _update()
 {
-	frames = ((frames+1)%30);
-	if (frames == 0 && level_index()<30) {
-		seconds = ((seconds+1)%60);
-		if (seconds == 0) {
-			minutes += 1;
+	if (++g->frames == 30)
+		g->frames = 0;
+	if (level_index()<30) {
+		g->run_frames += 1;
+		if (g->frames == 0) {
+			if (++g->seconds == 60)
+				g->seconds = 0;
+			if (g->seconds == 0) {
+				g->minutes += 1;
+			}
+			tick_time();
 		}
 	}
 
-	if (music_timer > 0) {
-		music_timer -= 1;
-		if (music_timer <= 0) {
+	if (g->music_timer > 0) {
+		g->music_timer -= 1;
+		if (g->music_timer <= 0) {
 			music(10,0,7);
 		}
 	}
 
-	if (sfx_timer > 0) {
-		sfx_timer -= 1;
+	if (g->sfx_timer > 0) {
+		g->sfx_timer -= 1;
 	}
 
 	//-- cancel if freeze
-	if (freeze > 0 ) { freeze -= 1; return;	}
+	if (g->freeze > 0 ) { g->freeze -= 1; return;	}
 
 	//-- screenshake
-	if (shake > 0) {
-		shake -= 1;
+	if (g->shake > 0) {
+		g->shake -= 1;
 		camera(0,0);
-		if (can_shake && shake > 0) {
+		if (can_shake && g->shake > 0) {
 			camera(-2-rndi(5),-2+rndi(5));
 		}
 	}
 
 	//-- restart (soon)
-	if (will_restart && delay_restart > 0) {
-		delay_restart -= 1;
-		if (delay_restart <= 0) {
-			will_restart = false;
-			load_room(room.x,room.y);
+	if (g->will_restart && g->delay_restart > 0) {
+		g->delay_restart -= 1;
+		if (g->delay_restart <= 0) {
+			g->will_restart = false;
+			load_room(g->room.x,g->room.y);
 		}
 	}
 
 	//-- update each object
-	if (player_spawn.active)
-		player_spawn_update(&player_spawn);
+	if (g->player_spawn.active)
+		player_spawn_update(&g->player_spawn);
 
-	if (player.obj.active)
+	if (g->player.obj.active)
 	{
-		move(&(player.obj),player.obj.spd.x,player.obj.spd.y);
-		player_update(&player);
+		move(&(g->player.obj),g->player.obj.spd.x,g->player.obj.spd.y);
+		player_update(&g->player);
 	}
 
-	if (key.active)
-		key_update(&key);
+	if (g->player.obj.active)
+		hair_update(clamp(g->player.obj.x,-1,121), g->player.obj.y, (g->player.obj.flip.x)? -1: 1);
+	else if (g->player_spawn.active)
+		hair_update(g->player_spawn.x, g->player_spawn.y, 1);
 
-	if (chest.obj.active)
-		chest_update(&chest);
+	if (g->key.active)
+		key_update(&g->key);
 
-	if (fruit.obj.active)
-		fruit_update(&fruit);
+	if (g->chest.obj.active)
+		chest_update(&g->chest);
 
-	if (fly_fruit.obj.active)
+	if (g->fruit.obj.active)
+		fruit_update(&g->fruit);
+
+	if (g->fly_fruit.obj.active)
 	{
-		move(&(fly_fruit.obj), fly_fruit.obj.spd.x, fly_fruit.obj.spd.y);
-		fly_fruit_update(&fly_fruit);
+		move(&(g->fly_fruit.obj), g->fly_fruit.obj.spd.x, g->fly_fruit.obj.spd.y);
+		fly_fruit_update(&g->fly_fruit);
 	}
 
-	if (fake_wall.active)
+	if (g->fake_wall.active)
 		fake_wall_update();
 
 	for (u8 i = 0; i < MAX_FALL_FLOORS; i++)
 	{
-		Fall_Floor* this = &(fall_floors[i]);
+		Fall_Floor* this = &(g->fall_floors[i]);
 		if (!this->obj.active)
 			break;
 		else
@@ -2191,7 +3031,7 @@ void _update()
 
 	for (u8 i = 0; i < MAX_SPRINGS; i++)
 	{
-		Spring* this = &(springs[i]);
+		Spring* this = &(g->springs[i]);
 		if (!this->obj.active)
 			break;
 		else
@@ -2200,7 +3040,7 @@ void _update()
 
 	for (u8 i = 0; i < MAX_BALLOONS; i++)
 	{
-		Balloon* this = &(balloons[i]);
+		Balloon* this = &(g->balloons[i]);
 		if (!this->obj.active)
 			break;
 		else
@@ -2209,21 +3049,21 @@ void _update()
 
 	//-- start game
 	if (is_title()) {
-		if (!start_game && (btn(k_jump) || btn(k_dash) || btnp(KEY_START))) {
+		if (!g->start_game && (btn(k_jump) || btn(k_dash) || btnp(KEY_START))) {
 			music(-1,0,0);
-			start_game_flash = 50;
-			start_game = true;
+			g->start_game_flash = 50;
+			g->start_game = true;
 			sfx(38);
 			if (btn(KEY_L) && btn(KEY_R))
-				cheated = true;
+				g->cheated = true;
 		}
 
-		if (start_game) {
-			start_game_flash -= 1;
-			if (start_game_flash <= -30) {
+		if (g->start_game) {
+			g->start_game_flash -= 1;
+			if (g->start_game_flash <= -30) {
 				begin_game();
-				if (cheated)
-					max_djump = 2;
+				if (g->cheated)
+					g->max_djump = 2;
 			}
 		}
 	}
@@ -2231,11 +3071,17 @@ void _update()
 
 //-- drawing functions --
 //-----------------------
-static s8 cloud_scroll[2] = { 0 };
+//every map row of clouds moves at its own speed, like the pico-8 clouds
+static const u8 cloud_speed[2][16] = {
+	{ 4,4,4,4,4,5,4,3,4,4,5,4,4,4,3,4 },	//close
+	{ 3,3,2,3,3,3,3,3,3,4,3,3,3,3,2,3 }	//far
+};
+static THREAD_LOCAL u16 cloud_bands[2] = { 0 };	//rows with clouds
+static THREAD_LOCAL u8 cloud_scroll[2][16] = { 0 };
 
 void _draw()
 {
-	if (freeze > 0) return;
+	if (g->freeze > 0) return;
 
 	//-- reset all palette values
 	pal(0,0,0);
@@ -2252,31 +3098,21 @@ void _draw()
 		print("noel berry",44,102,5);
 	}
 
-	//-- start game flash
-	if (start_game) {
-		u8 c = 10;
-		if (start_game_flash > 10) {
-			if (frames%10<5) {
-				c = 7;
+	//-- start game flash, white then down to black
+	if (g->start_game) {
+		if (g->start_game_flash > 10) {
+			if (mod10(g->frames)<5) {
+				fade(16,FADE_SCREEN);
 			}
 		}
-		else if (start_game_flash > 5) {
-			c = 2;
+		else if (g->start_game_flash > 5) {
+			fade(-10,FADE_SCREEN);
 		}
-		else if (start_game_flash > 0) {
-			c = 1;
+		else if (g->start_game_flash > 0) {
+			fade(-13,FADE_SCREEN);
 		}
 		else {
-			c = 0;
-		}
-
-		if (c < 10) {
-			pal(6, c,PAL_BG | PAL_SPRITES | PAL_TEXT);
-			pal(12,c,PAL_BG | PAL_SPRITES | PAL_TEXT);
-			pal(13,c,PAL_BG | PAL_SPRITES | PAL_TEXT);
-			pal(5, c,PAL_BG | PAL_SPRITES | PAL_TEXT);
-			pal(1, c,PAL_BG | PAL_SPRITES | PAL_TEXT);
-			pal(7, c,PAL_BG | PAL_SPRITES | PAL_TEXT);
+			fade(-16,FADE_SCREEN);
 		}
 
 		pal(1,0,PAL_BG); //hide clouds
@@ -2284,9 +3120,10 @@ void _draw()
 
 	//-- clear screen
 	u8 bg_col = 0;
-	if (flash_bg) {
-		bg_col = frames/5.f;
-	} else if (new_bg) {
+	if (g->flash_bg) {
+		//the backdrop runs through colors 0 to 5, one palette write
+		bg_col = div5(g->frames);
+	} else if (g->new_bg) {
 		bg_col = 2;
 		pal(1,14,PAL_BG);
 	}
@@ -2297,104 +3134,77 @@ void _draw()
 		pal(0,bg_col,PAL_BG);
 
 	//-- clouds
-	cloud_scroll[0] -= 4;
-	cloud_scroll[1] -= 3;
-	REG_BG2HOFS = cloud_scroll[0];
-	REG_BG3HOFS = cloud_scroll[1];
+	for (u8 l = 0; l < 2; l++)
+	{
+		for (u8 b = 0; b < 16; b++)
+		{
+			if (cloud_bands[l] & (1 << b))
+			{
+				cloud_scroll[l][b] -= cloud_speed[l][b];
+				parallax_band(l, b, cloud_scroll[l][b]);
+			}
+		}
+	}
 
 	//-- draw objects
-	if (flag.obj.active)
-		flag_draw(&flag);
+	if (landmark(type_flag))
+		flag_draw(&g->landmark.flag);
 
-	if (message.obj.active)
-		message_draw(&message);
+	if (landmark(type_message))
+		message_draw(&g->landmark.message);
 
-	if (lifeup.obj.active)
-		lifeup_draw(&lifeup);
+	if (g->lifeup.obj.active)
+		lifeup_draw(&g->lifeup);
 
-	if (room_title.active)
-		room_title_draw(&room_title);
+	if (g->room_title.active)
+		room_title_draw(&g->room_title);
 
-	if (fruit.obj.active)
-		draw_object(&(fruit.obj));
+	if (g->fruit.obj.active)
+		draw_object(&(g->fruit.obj));
 
-	if (fly_fruit.obj.active)
-		fly_fruit_draw(&fly_fruit);
-
-	for (u8 i = 0; i < MAX_SMOKE; i++)
-	{
-		Object* this = &(smoke[i]);
-		if (this->active)
-		{
-			move(this, this->spd.x, this->spd.y);
-			smoke_update(this);
-
-			if (this->active)
-				draw_object(this);
-		}
-	}
+	if (g->fly_fruit.obj.active)
+		fly_fruit_draw(&g->fly_fruit);
 
 	for (u8 i = 0; i < MAX_BALLOONS; i++)
 	{
-		Balloon* this = &(balloons[i]);
+		Balloon* this = &(g->balloons[i]);
 		if (!this->obj.active)
 			break;
 		else
 			balloon_draw(this);
 	}
 
-	if (player_spawn.active)
-		player_spawn_draw(&player_spawn);
+	if (g->player_spawn.active)
+		player_spawn_draw(&g->player_spawn);
 
-	if (player.obj.active)
-	{
-		player_draw(&player);
-	}
-	else
-	{
-		//-- dead particles
-		for (u8 i = 0; i < MAX_DEAD_PARTICLES; i++)
-		{
-			Dead_Particle* p = &(dead_particles[i]);
-			if (p->active)
-			{
-				p->x += p->spd.x;
-				p->y += p->spd.y;
-				p->t -= 1;
-				if (p->t <= 0)
-					p->active = false;
-				
-				pal(7,14+p->t%2,PAL_PLAYER);
-				spr(128+clamp((p->t/2),0,3),p->x-4,p->y-4,1,PAL_PLAYER,0,0);
-			}
-		}
-	}
+	if (g->player.obj.active)
+		player_draw(&g->player);
 
-	if (key.active)
-		draw_object(&key);
+	if (g->key.active)
+		draw_object(&g->key);
 
-	if (chest.obj.active)
-		draw_object(&(chest.obj));
+	if (g->chest.obj.active)
+		draw_object(&(g->chest.obj));
 
-	if (orb.obj.active)
+	if (g->orb.obj.active)
 	{
-		move(&(orb.obj),orb.obj.spd.x,orb.obj.spd.y);
-		orb_draw(&orb);
+		move(&(g->orb.obj),g->orb.obj.spd.x,g->orb.obj.spd.y);
+		orb_draw(&g->orb);
 	}
 
-	if (fake_wall.active)
+	if (g->fake_wall.active)
 		fake_wall_draw();
 
 	for (u8 i = 0; i < MAX_SPRINGS; i++)
 	{
-		Object* this = &(springs[i].obj);
+		Object* this = &(g->springs[i].obj);
 		if (this->active)
 			draw_object(this);
 	}
 
 	for (u8 i = 0; i < MAX_FALL_FLOORS; i++)
 	{
-		Fall_Floor* this = &(fall_floors[i]);
+		Fall_Floor* this = &(g->fall_floors[i]);
 		if (!this->obj.active)
 			break;
 		else
@@ -2404,7 +3214,7 @@ void _draw()
 	//-- platforms/big chest
 	for (u8 i = 0; i < MAX_PLATFORMS; i++)
 	{
-		Platform* this = &(platforms[i]);
+		Platform* this = &(g->platforms[i]);
 		if (!this->obj.active)
 			break;
 		else
@@ -2414,24 +3224,11 @@ void _draw()
 		}
 	}
 
-	if (big_chest.obj.active)
-		big_chest_draw(&big_chest);
+	if (landmark(type_big_chest))
+		big_chest_draw(&g->landmark.big_chest);
 
-	//-- particles
-	for (u8 i = 0; i < MAX_PARTICLES; i++)
-	{
-		Particle* p = &(particles[i]);
-		p->x += p->spd;
-		p->y += sin(p->off);
-		p->off += min(0.05,p->spd/32);
-		spr(128+p->s,p->x,p->y,1,0,0,0);
-		//spr(128+p->s,p->x,p->y+64,1,0,0,0);
-		if (p->x > 128+4) {
-			p->x = -4;
-			p->y = rndi(128);
-			//p->y = rndi(64);
-		}
-	}
+	//-- smoke, dead, chest and ambient particles
+	fx_draw();
 }
 
 static void init_clouds()
@@ -2463,7 +3260,10 @@ static void init_clouds()
 			{
 				u8 val = cloud_map[x+(y*32)];
 				if (val != 0)
+				{
 					*map_adr = 134 + val;
+					cloud_bands[0] |= 1 << y;
+				}
 				map_adr++;
 			}
 		}
@@ -2496,7 +3296,10 @@ static void init_clouds()
 			{
 				u8 val = cloud_map[x+(y*32)];
 				if (val != 0)
+				{
 					*map_adr = 134 + val;
+					cloud_bands[1] |= 1 << y;
+				}
 				map_adr++;
 			}
 		}
@@ -2518,24 +3321,9 @@ static void init_overlay()
 	}
 }
 
-int main(void)
+//graphics, layers, clouds and border, the host tools that draw call it too
+static void init_video()
 {
-	// Set up the interrupt handlers
-	irqInit();
-
-	// Maxmod requires the vblank interrupt to reset sound DMA.
-	// Link the VBlank interrupt to mmVBlank, and enable it. 
-	irqSet(IRQ_VBLANK, mmVBlank);
-
-	// Enable Vblank Interrupt to allow VblankIntrWait
-	irqEnable(IRQ_VBLANK);
-
-	// initialise maxmod with soundbank and 8 channels
-    mmInitDefault((mm_addr)soundbank_bin, 8);
-    mmSetModuleVolume(1024);
-    mmSetJingleVolume(1024);
-
-	//load graphics
 	CpuFastSet(GFX_DATA, TILE_BASE_ADR(0), (GFX_SIZE/4) | COPY32);
 	CpuFastSet(GFX_DATA, SPRITE_GFX, (GFX_SIZE/4) | COPY32);
 	CpuFastSet(FNT_DATA, SPRITE_GFX + 0x1000, (FNT_SIZE/4) | COPY32);
@@ -2549,26 +3337,181 @@ int main(void)
 	init_overlay();
 
 	SetMode(MODE_0 | BG_ALL_ON | OBJ_ENABLE);
+}
+
+//-- Game benchmark --
+//--------------------
+#ifdef BENCH
+
+#define BENCH_WARMUP 30
+#define BENCH_FRAMES 60
+
+//held for 6 frames each, picked by a fixed sequence
+static const u16 bench_inputs[] = {
+	0, k_right, k_left, k_right|k_jump, k_left|k_jump, k_up|k_dash,
+	k_right|k_up|k_dash, k_left|k_up|k_dash, k_right|k_dash, k_down|k_dash
+};
+
+//plays every room with the same inputs and measures each subsystem
+void game_bench()
+{
+	static EWRAM_BSS Bench_Result results[BENCH_ROOMS][BENCH_SUBSYSTEMS];
+
+	init_cycles();
+	__init();
+	begin_game();
+	g->practice = true;	//don't keep splits from the bench
+
+	for (u8 r = 0; r < BENCH_ROOMS; r++)
+	{
+		u8 x = r%8, y = r/8;
+		u32 total[BENCH_SUBSYSTEMS] = { 0 };
+		u32 seed = 1+r;
+		u16 keys = 0;
+
+		memset(results[r], 0, sizeof(results[r]));
+		rnd_seed = 1;
+		g->kheld = 0;
+		load_room(x,y);
+
+		for (u16 f = 0; f < BENCH_WARMUP+BENCH_FRAMES; f++)
+		{
+			u32 cost[BENCH_SUBSYSTEMS];
+			u32 start;
+
+			if (f%6 == 0)
+			{
+				seed = seed*1664525 + 1013904223;
+				keys = bench_inputs[(seed >> 8) % (sizeof(bench_inputs)/sizeof(bench_inputs[0]))];
+			}
+			g->kdown = keys & ~g->kheld;
+			g->kheld = keys;
+
+			//update
+			VBlankIntrWait();
+			start = cycles();
+			update_audio();
+			cost[BENCH_AUDIO] = cycles() - start;
+
+#ifdef DIVCOUNT
+			div_calls = 0;
+#endif
+			start = cycles();
+			_update();
+			cost[BENCH_UPDATE] = cycles() - start;
+#ifdef DIVCOUNT
+			cost[BENCH_DIVS] = div_calls;
+#endif
+
+			//draw
+			VBlankIntrWait();
+			start = cycles();
+			update_audio();
+			cost[BENCH_AUDIO] += cycles() - start;
+
+#ifdef DIVCOUNT
+			div_calls = 0;
+#endif
+			start = cycles();
+			_draw();
+			cost[BENCH_DRAW] = cycles() - start;
+#ifdef DIVCOUNT
+			cost[BENCH_DIVS] += div_calls;
+#endif
+
+			//handing the frame over, and the interrupt showing the last one
+			start = cycles();
+			if (g->freeze <= 0)
+				update_screen();
+			cost[BENCH_SCREEN] = cycles() - start + screen_vblank_cost();
+
+			//stay in the room when the inputs leave it
+			if (g->room.x != x || g->room.y != y)
+				load_room(x,y);
+
+			if (f < BENCH_WARMUP)
+				continue;
+
+			for (u8 i = 0; i < BENCH_SUBSYSTEMS; i++)
+			{
+				total[i] += cost[i];
+				if (cost[i] > results[r][i].max)
+					results[r][i].max = cost[i];
+			}
+		}
+
+		for (u8 i = 0; i < BENCH_SUBSYSTEMS; i++)
+			results[r][i].avg = total[i] / BENCH_FRAMES;
+	}
+
+	bench_report(results);
+}
+
+#endif
+
+
+//-- interrupts --
+//----------------
+//maxmod, then the last frame _draw() finished and its cloud scroll table
+static void vblank()
+{
+	mmVBlank();
+	frame_vblank();
+	screen_vblank();
+	parallax_vblank();
+	pacing_vblank();
+}
+
+
+int main(void)
+{
+	// Set up the interrupt handlers
+	irqInit();
+
+	// Maxmod requires the vblank interrupt to reset sound DMA.
+	// Link the VBlank interrupt to mmVBlank and the screen commits, and enable it.
+	irqSet(IRQ_VBLANK, vblank);
+
+	// Enable Vblank Interrupt to allow VblankIntrWait
+	irqEnable(IRQ_VBLANK);
+
+	// initialise maxmod with soundbank and separate music/sfx channels
+	init_audio();
+
+	init_video();
+
+#ifdef AUDIO_BENCH
+	audio_bench();
+#endif
 
 	//game start
 	camera(0,0);
 
+#ifdef BENCH
+	game_bench();
+#endif
+
 	__init();
+	init_cycles();
 
 	bool paused = false;
+	bool show_pacing = false;
 	while (1)
 	{
 		//update
-		VBlankIntrWait();
-		mmFrame();
+		frame_wait();
+		pacing_begin();
 
 		scanKeys();
-		kheld = keysHeld();
-		kdown = keysDown();
+		g->kheld = keysHeld();
+		g->kdown = keysDown();
 
 		//if (btnp(KEY_SELECT))
 		//	next_room();		
 		
+		//a select press that leaves the stats is used up
+		bool resumed = false;
+
 		if (btnp(KEY_START))
 		{
 			if (level_index() < 30)
@@ -2581,17 +3524,37 @@ int main(void)
 					mmResume();
 			}
 		}
+		//frame pacing stats while paused, select again to play on
+		else if (paused && btnp(KEY_SELECT))
+		{
+			show_pacing = !show_pacing;
+			if (show_pacing)
+				pacing_save();
+			else
+			{
+				paused = false;
+				resumed = true;
+				mmResume();
+			}
+		}
 
 		if (!paused)
 		{
-			if (freeze <= 0)
-				update_screen();
-	
-			_update();
-			
+			bool select = btnp(KEY_SELECT) && !resumed;
+
+			//quick save (L+select) and quick load (R+select)
+			if (select && !btn(KEY_START) && !is_title() && btn(KEY_L) != btn(KEY_R))
+			{
+				if (btn(KEY_L))
+					save_state();
+				else
+					load_state();
+			}
 			//toggle screen shake
-			if (btnp(KEY_SELECT))
+			else if (select)
 				can_shake = !can_shake;
+
+			_update();
 		}
 		
 		//reset key combo
@@ -2604,12 +3567,22 @@ int main(void)
 			}
 		}
 
-		//draw
-		VBlankIntrWait();
-		mmFrame();
+		//draw, straight after the update
+		frame_audio();
 
 		if (!paused)
-			_draw();		
+		{
+			show_pacing = false;
+			_draw();
+			if (g->freeze <= 0)
+				update_screen();
+			pacing_end(level_index());
+		}
+		else if (show_pacing)
+		{
+			pacing_draw();
+			update_screen();
+		}
 	}
 
 	return 0;
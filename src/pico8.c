@@ -1,16 +1,22 @@
 #include "pico8.h"
 
+#include <gba_dma.h>
+#include <gba_interrupt.h>
 #include <gba_sprites.h>
+#include <gba_timers.h>
 #include <gba_video.h>
 #include <maxmod.h>
-#include <stdlib.h>
+#include <string.h>
 
 #include "soundbank.h"
 #include "soundbank_bin.h"
 
 //-- Graphics --
 //--------------
-static OBJATTR obj_buffer[128] = { 0 };
+//_draw() fills the back one of two oam copies while the vblank interrupt
+//shows the other, see update_screen()
+static THREAD_LOCAL OBJATTR obj_buffers[2][128] ALIGN(4);
+static THREAD_LOCAL u8 obj_back = 0;
 
 static const u16 palette[16] = {
 	RGB8(0x00,0x00,0x00),	//black
@@ -31,10 +37,14 @@ static const u16 palette[16] = {
 	RGB8(0xFF,0xCC,0xAA)	//peach
 };
 
-static s16 camx = 0;
-static s16 camy = 0;
-static s16 borderx = 0;
-static s16 bordery = 0;
+static THREAD_LOCAL s16 camx = 0;
+static THREAD_LOCAL s16 camy = 0;
+static THREAD_LOCAL s16 borderx = 0;
+static THREAD_LOCAL s16 bordery = 0;
+
+//palettes as pal() leaves them: bg 0 and 1, sprite 0 to 4
+static THREAD_LOCAL u16 bg_palette[32] ALIGN(4);
+static THREAD_LOCAL u16 obj_palette[80] ALIGN(4);
 
 void camera(s16 x, s16 y)
 {
@@ -53,53 +63,61 @@ void pal(u8 c0, u8 c1, u8 p)
 		for (int i = 0; i < 16; i++)
 		{
 			if (p == 0 || p & PAL_BG)
-				BG_PALETTE[i] = palette[i];
+				bg_palette[i] = palette[i];
 
 			if (p == 0 || p & PAL_OVERLAY)
-				BG_PALETTE[16 + i] = palette[i];
+				bg_palette[16 + i] = palette[i];
 
 			if (p == 0 || p & PAL_SPRITES)
-				SPRITE_PALETTE[i] = palette[i];
+				obj_palette[i] = palette[i];
 
 			if (p == 0 || p & PAL_PLAYER)	
-				SPRITE_PALETTE[16 + i] = palette[i];
+				obj_palette[16 + i] = palette[i];
 
 			if (p == 0 || p & PAL_TEXT)
-				SPRITE_PALETTE[32 + i] = palette[i];
+				obj_palette[32 + i] = palette[i];
 
 			if (p == 0 || p & PAL_OVERLAY)
-				SPRITE_PALETTE[48 + i] = palette[i];
+				obj_palette[48 + i] = palette[i];
+
+			if (p == 0 || p & PAL_TEXT2)
+				obj_palette[64 + i] = palette[i];
 		}
 	}
 	else
 	{
 		if (p & PAL_BG)
-			BG_PALETTE[c0] = palette[c1];
+			bg_palette[c0] = palette[c1];
 
 		if (p & PAL_OVERLAY)
-			BG_PALETTE[16 + c0] = palette[c1];
+			bg_palette[16 + c0] = palette[c1];
 
 		if (p & PAL_SPRITES)
-			SPRITE_PALETTE[c0] = palette[c1];
+			obj_palette[c0] = palette[c1];
 
 		if (p & PAL_PLAYER)
-			SPRITE_PALETTE[16 + c0] = palette[c1];
+			obj_palette[16 + c0] = palette[c1];
 
 		if (p & PAL_TEXT)
-			SPRITE_PALETTE[32 + c0] = palette[c1];
+			obj_palette[32 + c0] = palette[c1];
 
 		if (p & PAL_OVERLAY)
-			SPRITE_PALETTE[48 + c0] = palette[c1];
+			obj_palette[48 + c0] = palette[c1];
+
+		if (p & PAL_TEXT2)
+			obj_palette[64 + c0] = palette[c1];
 	}
 }
 
-void print(char const* str, u8 x, u8 y, u8 col)
+//the glyphs are drawn in color 7 of a sprite palette, every string of a
+//frame printed with the same palette shows in the same color
+static void print_pal(char const* str, u8 x, u8 y, u8 col, u8 p)
 {
 	x += 4;
 
 	u8 xstart = x;
 	
-	pal(7,col,PAL_TEXT);
+	pal(7,col,p);
 
 	u16 i = 0;
 	while (str[i] != '\0')
@@ -111,44 +129,91 @@ void print(char const* str, u8 x, u8 y, u8 col)
 		}
 		else
 		{
-			spr(256+str[i]-' ', x, y, 0, PAL_TEXT, 0, 0);
+			spr(256+str[i]-' ', x, y, 0, p, 0, 0);
 			x += 4;
 		}
 		i++;
 	}
 }
 
-static bool rect_drawn = false;
+void print(char const* str, u8 x, u8 y, u8 col)
+{
+	print_pal(str, x, y, col, PAL_TEXT);
+}
+
+void print2(char const* str, u8 x, u8 y, u8 col)
+{
+	print_pal(str, x, y, col, PAL_TEXT2);
+}
+
+//solid boxes made with the window registers, nothing but the overlay shows
+//inside them so the backdrop color does the fill
+typedef struct
+{
+	u8 x, y, w, h;
+} Win_Box;
+
+static THREAD_LOCAL Win_Box win_boxes[2];
+static THREAD_LOCAL u8 win_count = 0;
+
+//overlay rectangles, one bit per cell of the 16x16 screen. rectfill() only
+//marks cells, update_screen() writes the ones that changed in vblank.
+static THREAD_LOCAL u16 rect_cells[16];	//drawn this frame
+static THREAD_LOCAL u16 rect_shown[16];	//in vram
 
 void rectfill(u8 x, u8 y, u8 w, u8 h, s8 col)
 {
+	//col < 0 clears, windows included
 	if (col >= 0)
-	{
-		rect_drawn = true;
 		pal(10,col,PAL_BG);
-	}
 	else
+		win_count = 0;
+
+	u16 mask = ((1 << w)-1) << x;
+
+	for (u8 iy = y; iy < y+h && iy < 16; iy++)
 	{
-		//clear drawn rectangles
-		if (rect_drawn == false)
-			return;
-		rect_drawn = false;
+		if (col >= 0)
+			rect_cells[iy] |= mask;
+		else
+			rect_cells[iy] &= ~mask;
 	}
+}
 
-	u16* map_adr = MAP_BASE_ADR(3);
-
-	for (u8 iy = 3+y; iy < 3+y+h; iy++)
+//falls back to tiles when the backdrop isn't col or both windows are used
+void winfill(u8 x, u8 y, u8 w, u8 h, s8 col)
+{
+	if (win_count >= 2 || bg_palette[0] != palette[col])
 	{
-		for (u8 ix = 8+x; ix < 8+x+w; ix++)
-			map_adr[ix+(iy*32)] = (col >= 0)? 138: 0;
+		rectfill(x,y,w,h,col);
+		return;
 	}
+
+	Win_Box* box = &(win_boxes[win_count++]);
+	box->x = x;
+	box->y = y;
+	box->w = w;
+	box->h = h;
+}
+
+//brightness fades in the blend registers instead of palette remaps, they
+//only last for the frame they were set in
+static THREAD_LOCAL u16 fade_cnt = 0;
+static THREAD_LOCAL u16 fade_y = 0;
+
+void fade(s8 level, u8 layers)
+{
+	//brighten above 0, darken below
+	fade_cnt = (level == 0)? 0: layers | ((level > 0)? 0x0080: 0x00c0);
+	fade_y = min(16, (level < 0)? -level: level);
 }
 
-static u8 sprite_index = 0;
+static THREAD_LOCAL u8 sprite_index = 0;
 
 void spr(u16 n, s16 x, s16 y, u8 layer, u8 palette, bool flip_x, bool flip_y)
 {
-	OBJATTR* obj = &(obj_buffer[sprite_index]);
+	OBJATTR* obj = &(obj_buffers[obj_back][sprite_index]);
+	cost_count(COST_SPR);
 	obj->attr0 = OBJ_Y(y-camy) | ATTR0_COLOR_16 | ATTR0_SQUARE;
 	obj->attr1 = OBJ_X(x-camx) | ATTR1_SIZE_8;
 	obj->attr2 = OBJ_CHAR(n) | OBJ_PRIORITY(layer) | OBJ_SQUARE;
@@ -162,6 +227,8 @@ void spr(u16 n, s16 x, s16 y, u8 layer, u8 palette, bool flip_x, bool flip_y)
 		obj->attr2 |= ATTR2_PALETTE(2);
 	else if (palette & PAL_OVERLAY)
 		obj->attr2 |= ATTR2_PALETTE(3);
+	else if (palette & PAL_TEXT2)
+		obj->attr2 |= ATTR2_PALETTE(4);
 
 	//flip
 	if (flip_x)
@@ -175,78 +242,570 @@ void spr(u16 n, s16 x, s16 y, u8 layer, u8 palette, bool flip_x, bool flip_y)
 		sprite_index = 0;
 }
 
-void update_screen()
+//what update_screen() hands to the vblank interrupt besides the sprites
+typedef struct
+{
+	u16 bg_palette[32];
+	u16 obj_palette[80];
+	u16 rect_cells[16];
+	Win_Box win_boxes[2];
+	u8 win_count;
+	s16 camx, camy;
+	s16 borderx, bordery;
+	u16 fade_cnt, fade_y;
+	u8 scroll;	//cloud scroll table, see Parallax
+} ALIGN(4) Frame;
+
+static THREAD_LOCAL Frame frames[2];
+static THREAD_LOCAL u8 sprite_counts[2];
+static THREAD_LOCAL volatile s8 frame_ready = -1;
+static THREAD_LOCAL u32 vblank_cost = 0;
+
+//game frames start every 2nd vblank (frame_wait()), a finished frame is
+//shown on the vblank that ends it. tools that never wait show every frame.
+static THREAD_LOCAL volatile u16 vblank_count = 0;
+static THREAD_LOCAL volatile u16 commit_due = 0;
+static THREAD_LOCAL volatile bool paced = false;
+
+//scroll of the cloud layers (bg2, bg3) per scanline, written by hblank dma
+//after every line. two tables: one is shown while _draw() fills the other,
+//only the lines of bands that move are written. the filled one goes out
+//with the frame, so the clouds and the rest of the screen change together.
+static THREAD_LOCAL u16 scroll_lines[2][161][4] ALIGN(4);	//bg2 h/v, bg3 h/v
+static THREAD_LOCAL u8 scroll_back = 1;
+static THREAD_LOCAL volatile u8 scroll_front = 0;
+
+static void commit_windows(const Frame* f)
+{
+	u16 dispcnt = REG_DISPCNT & ~(WIN0_ON | WIN1_ON);
+
+	for (u8 i = 0; i < f->win_count; i++)
+	{
+		//the overlay moves with the border when the screen shakes
+		const Win_Box* box = &(f->win_boxes[i]);
+		s16 left = (8+box->x)*8 - f->borderx;
+		s16 top = (3+box->y)*8 - f->bordery;
+		u16 h = (max(0,min(240,left)) << 8) | max(0,min(240,left+box->w*8));
+		u16 v = (max(0,min(160,top)) << 8) | max(0,min(160,top+box->h*8));
+
+		if (i == 0)
+		{
+			REG_WIN0H = h;
+			REG_WIN0V = v;
+			dispcnt |= WIN0_ON;
+		}
+		else
+		{
+			REG_WIN1H = h;
+			REG_WIN1V = v;
+			dispcnt |= WIN1_ON;
+		}
+	}
+
+	REG_WININ = 0x0101;	//overlay only
+	REG_WINOUT = 0x003f;	//everything
+	REG_DISPCNT = dispcnt;
+}
+
+static void commit_rects(const u16* cells)
 {
-	//game screen position
-	REG_BG1HOFS = camx;
-	REG_BG1VOFS = camy;
+	u16* map_adr = (u16*)MAP_BASE_ADR(3) + 8 + 3*32;
 
-	//black border position
-	REG_BG0HOFS = borderx;
-	REG_BG0VOFS = bordery;
+	for (u8 y = 0; y < 16; y++, map_adr += 32)
+	{
+		u16 changed = cells[y] ^ rect_shown[y];
+		if (changed == 0)
+			continue;
 
-	//upload OAM copy to real OAM
-	CpuFastSet(obj_buffer, OAM, ((sizeof(OBJATTR)*128)/4) | COPY32);
+		for (u8 x = 0; changed; x++, changed >>= 1)
+		{
+			if (changed & 1)
+				map_adr[x] = (cells[y] & (1 << x))? 138: 0;
+		}
+		rect_shown[y] = cells[y];
+	}
+}
 
-	//wipe OAM copy
-	for (u8 i = 0; i < sprite_index; i++)
-		obj_buffer[i].attr0 = OBJ_DISABLE;
+//the frame is done: it goes to the vblank interrupt, which shows the newest
+//one it hasn't shown yet, and the next frame is drawn into the other copy
+void update_screen()
+{
+	Frame* f = &(frames[obj_back]);
+
+	memcpy(f->bg_palette, bg_palette, sizeof(bg_palette));
+	memcpy(f->obj_palette, obj_palette, sizeof(obj_palette));
+	memcpy(f->rect_cells, rect_cells, sizeof(rect_cells));
+	memcpy(f->win_boxes, win_boxes, sizeof(win_boxes));
+	f->win_count = win_count;
+	f->camx = camx;
+	f->camy = camy;
+	f->borderx = borderx;
+	f->bordery = bordery;
+	f->fade_cnt = fade_cnt;
+	f->fade_y = fade_y;
+	fade_cnt = 0;
+	fade_y = 0;
+
+	f->scroll = scroll_back;
+	scroll_back ^= 1;
+
+	sprite_counts[obj_back] = sprite_index;
+
+	//the frame's plain stores have to land before the interrupt can see it
+	__asm__ volatile("" ::: "memory");
+	frame_ready = obj_back;
+	obj_back ^= 1;
+
+	//wipe the copy shown before
+	for (u8 i = 0; i < sprite_counts[obj_back]; i++)
+		obj_buffers[obj_back][i].attr0 = OBJ_DISABLE;
 
 	sprite_index = 0;
 }
 
+//from the vblank interrupt, everything lands before the first line
+void screen_vblank()
+{
+	s8 ready = frame_ready;
+	if (ready < 0 || (paced && (s16)(vblank_count - commit_due) < 0))
+		return;
+
+	u32 start = cycles();
+	const Frame* f = &(frames[ready]);
+
+	//game screen and black border position
+	REG_BG1HOFS = f->camx;
+	REG_BG1VOFS = f->camy;
+	REG_BG0HOFS = f->borderx;
+	REG_BG0VOFS = f->bordery;
+
+	commit_rects(f->rect_cells);
+	commit_windows(f);
+	REG_BLDCNT = f->fade_cnt;
+	REG_BLDY = f->fade_y;
+	scroll_front = f->scroll;
+
+	CpuFastSet(f->bg_palette, BG_PALETTE, (sizeof(f->bg_palette)/4) | COPY32);
+	CpuFastSet(f->obj_palette, SPRITE_PALETTE, (sizeof(f->obj_palette)/4) | COPY32);
+	CpuFastSet(obj_buffers[ready], OAM, ((sizeof(OBJATTR)*128)/4) | COPY32);
+
+	frame_ready = -1;
+	vblank_cost = cycles() - start;
+}
+
+u32 screen_vblank_cost()
+{
+	return vblank_cost;
+}
+
+
+//-- Frame timing --
+//------------------
+static THREAD_LOCAL u16 audio_vblank = 0;
+static THREAD_LOCAL u16 frame_due = 0;
+
+void frame_vblank()
+{
+	vblank_count += 1;
+}
+
+void frame_audio()
+{
+	if (audio_vblank == vblank_count)
+		return;
+
+	audio_vblank = vblank_count;
+	update_audio();
+}
+
+void frame_wait()
+{
+	frame_audio();
+
+	//IntrWait(0) returns at once for a vblank that came after the check
+	while ((s16)(vblank_count - frame_due) < 0)
+	{
+		IntrWait(0, IRQ_VBLANK);
+		frame_audio();
+	}
+
+	//a late frame starts the next one at once and moves the beat
+	frame_due = vblank_count + 2;
+	commit_due = frame_due;
+	paced = true;
+}
+
+
+//-- Parallax --
+//--------------
+//the tables are with the frames above, update_screen() hands them over
+void parallax_band(u8 layer, u8 band, u8 x)
+{
+	if (band >= PARALLAX_BANDS)
+		return;
+
+	u16* line = scroll_lines[scroll_back][band*8] + layer*2;
+	for (u8 i = 0; i < 8; i++, line += 4)
+		*line = x;
+}
+
+//from the vblank interrupt: line 0 is set now, the dma does the rest
+void parallax_vblank()
+{
+	u16* table = scroll_lines[scroll_front][0];
+
+	REG_DMA0CNT = 0;
+	REG_BG2HOFS = table[0];
+	REG_BG2VOFS = table[1];
+	REG_BG3HOFS = table[2];
+	REG_BG3VOFS = table[3];
+
+	REG_DMA0SAD = (uintptr_t)(table + 4);
+	REG_DMA0DAD = (uintptr_t)&REG_BG2HOFS;
+	REG_DMA0CNT = DMA_ENABLE | DMA_HBLANK | DMA_REPEAT | DMA32 | DMA_SRC_INC | DMA_DST_RELOAD | 2;
+}
+
 
 //-- Audio --
 //-----------
+#define MIX_CHANNELS (MUSIC_CHANNELS + SFX_CHANNELS)
+
+#define MIX_MODE_(r) MM_MIX_##r##KHZ
+#define MIX_MODE(r) MIX_MODE_(r)
+#define MIX_LEN_(r) MM_MIXLEN_##r##KHZ
+#define MIX_LEN(r) MIX_LEN_(r)
+#define MUSIC_VOLUME 1024
+
+//pico-8 sfx/music numbers to soundbank ids, generated from soundbank.h
+static const s16 sfx_map[64] = {
+	[0 ... 63] = -1,
+	#include "sfx_map.h"
+};
+
+static const s16 music_map[64] = {
+	[0 ... 63] = -1,
+	#include "music_map.h"
+};
+
+//only the mixing buffer needs to be in iwram
+static u8 mod_channels[MUSIC_CHANNELS * MM_SIZEOF_MODCH] ALIGN(4) EWRAM_BSS;
+static u8 act_channels[MIX_CHANNELS * MM_SIZEOF_ACTCH] ALIGN(4) EWRAM_BSS;
+static u8 mix_channels[MIX_CHANNELS * MM_SIZEOF_MIXCH] ALIGN(4) EWRAM_BSS;
+static u8 mixing_buffer[MIX_LEN(MIX_RATE)] ALIGN(4);
+static u8 wave_buffer[MIX_LEN(MIX_RATE)] ALIGN(4) EWRAM_BSS;
+
+static THREAD_LOCAL s32 music_volume = 0;	//16.16 fixed point
+static THREAD_LOCAL s32 music_fade = 0;		//volume change per frame
+static THREAD_LOCAL s8 music_current = -1;
+
+//-- sfx voices --
+//a retrigger of the same effect within this many frames is dropped
+#define SFX_DEDUP_FRAMES 4
+
+typedef struct
+{
+	mm_sfxhand handle;	//0 when free
+	u8 n;
+	u8 priority;
+	u16 start;
+} Voice;
+
+static THREAD_LOCAL Voice voices[SFX_CHANNELS];
+static THREAD_LOCAL u16 sfx_last[64];
+static THREAD_LOCAL u16 audio_frame = 0;
+static THREAD_LOCAL Sfx_Stats sfx_counts = { 0 };
+static THREAD_LOCAL Sfx_Stats sfx_frame_stats = { 0 };
+
+//higher priority effects can take a voice from lower or equal ones
+static const u8 sfx_priority[64] = {
+	[0 ... 63] = 1,
+	[35] = 0,	//message text
+	[1] = 2, [2] = 2, [3] = 2, [4] = 2, [5] = 2,	//jumps, dash, spawn
+	[0] = 3,	//death
+	[13] = 3, [14] = 3, [16] = 3, [23] = 3,	//fruit, key, chest
+	[37] = 3, [38] = 3, [51] = 3, [55] = 3	//big chest, start, orb, summit
+};
+
+void init_audio()
+{
+	//effects get their own mixer channels past the module's,
+	//so they never steal a channel from the music
+	//(this is what channel_mask reserves in pico-8)
+	mm_gba_system sys;
+	sys.mixing_mode = MIX_MODE(MIX_RATE);
+	sys.mod_channel_count = MUSIC_CHANNELS;
+	sys.mix_channel_count = MIX_CHANNELS;
+	sys.module_channels = (mm_addr)mod_channels;
+	sys.active_channels = (mm_addr)act_channels;
+	sys.mixing_channels = (mm_addr)mix_channels;
+	sys.mixing_memory = (mm_addr)mixing_buffer;
+	sys.wave_memory = (mm_addr)wave_buffer;
+	sys.soundbank = (mm_addr)soundbank_bin;
+	mmInit(&sys);
+
+	music_volume = MUSIC_VOLUME << 16;
+	mmSetModuleVolume(MUSIC_VOLUME);
+	mmSetJingleVolume(MUSIC_VOLUME);
+
+	for (u8 i = 0; i < 64; i++)
+		sfx_last[i] = audio_frame - SFX_DEDUP_FRAMES;
+}
+
+void update_audio()
+{
+	if (music_fade != 0)
+	{
+		music_volume += music_fade;
+
+		if (music_volume >= (MUSIC_VOLUME << 16))
+		{
+			music_volume = MUSIC_VOLUME << 16;
+			music_fade = 0;
+		}
+		else if (music_volume <= 0)
+		{
+			//faded out
+			music_volume = 0;
+			music_fade = 0;
+			mmStop();
+		}
+
+		mmSetModuleVolume(music_volume >> 16);
+	}
+
+	//free finished voices
+	sfx_counts.voices = 0;
+	for (u8 i = 0; i < SFX_CHANNELS; i++)
+	{
+		Voice* v = &voices[i];
+		if (v->handle != 0)
+		{
+			if (mmEffectActive(v->handle))
+				sfx_counts.voices += 1;
+			else
+				v->handle = 0;
+		}
+	}
+
+	sfx_frame_stats = sfx_counts;
+	sfx_counts.requested = 0;
+	sfx_counts.played = 0;
+	sfx_counts.deduped = 0;
+	sfx_counts.dropped = 0;
+	sfx_counts.stolen = 0;
+	audio_frame += 1;
+
+	mmFrame();
+}
+
 void music(s8 n, u16 fade_len, u8 channel_mask)
 {
-	mmStop();
+	//fade length is in milliseconds, the fade runs at 60 steps a second
+	s32 step = 0;
+	if (fade_len > 0)
+		step = (MUSIC_VOLUME << 16) / ((fade_len * 60) / 1000 + 1);
 
-	switch (n)
+	if (n < 0)
 	{
-		case  0: mmStart(MOD_MUS0,  MM_PLAY_LOOP); break;
-		case 10: mmStart(MOD_MUS10, MM_PLAY_LOOP); break;
-		case 20: mmStart(MOD_MUS20, MM_PLAY_LOOP); break;
-		case 30: mmStart(MOD_MUS30, MM_PLAY_LOOP); break;
-		case 40: mmStart(MOD_MUS40, MM_PLAY_LOOP); break;
+		music_current = -1;
+
+		if (step == 0 || !mmActive())
+		{
+			mmStop();
+			music_fade = 0;
+		}
+		else
+			music_fade = -step;
+
+		return;
+	}
+
+	if (n >= 64 || music_map[n] < 0)
+		return;
+
+	music_current = n;
+
+	//fade in from silence
+	if (step == 0)
+	{
+		music_volume = MUSIC_VOLUME << 16;
+		music_fade = 0;
+	}
+	else
+	{
+		music_volume = 0;
+		music_fade = step;
 	}
+	mmSetModuleVolume(music_volume >> 16);
+
+	mmStart(music_map[n], MM_PLAY_LOOP);
 }
 
 void sfx(u8 n)
 {
-	switch (n)
+	sfx_counts.requested += 1;
+
+	if (n >= 64 || sfx_map[n] < 0)
+		return;
+
+	if ((u16)(audio_frame - sfx_last[n]) < SFX_DEDUP_FRAMES)
 	{
-		case  0: mmEffect(SFX_SND0);  break;
-		case  1: mmEffect(SFX_SND1);  break;
-		case  2: mmEffect(SFX_SND2);  break;
-		case  3: mmEffect(SFX_SND3);  break;
-		case  4: mmEffect(SFX_SND4);  break;
-		case  5: mmEffect(SFX_SND5);  break;
-		case  6: mmEffect(SFX_SND6);  break;
-		case  7: mmEffect(SFX_SND7);  break;
-		case  8: mmEffect(SFX_SND8);  break;
-		case  9: mmEffect(SFX_SND9);  break;
-		case 13: mmEffect(SFX_SND13); break;
-		case 14: mmEffect(SFX_SND14); break;
-		case 15: mmEffect(SFX_SND15); break;
-		case 16: mmEffect(SFX_SND16); break;
-		case 23: mmEffect(SFX_SND23); break;
-		case 35: mmEffect(SFX_SND35); break;
-		case 37: mmEffect(SFX_SND37); break;
-		case 38: mmEffect(SFX_SND38); break;
-		case 40: mmEffect(SFX_SND40); break;
-		case 51: mmEffect(SFX_SND51); break;
-		case 54: mmEffect(SFX_SND54); break;
-		case 55: mmEffect(SFX_SND55); break;
+		sfx_counts.deduped += 1;
+		return;
 	}
+
+	//restart the effect if it's still playing (like pico-8), otherwise
+	//take a free voice or the oldest one of the lowest priority
+	u8 priority = sfx_priority[n];
+	Voice* v = NULL;
+	Voice* victim = NULL;
+	for (u8 i = 0; i < SFX_CHANNELS; i++)
+	{
+		Voice* other = &voices[i];
+		if (other->handle == 0)
+		{
+			if (v == NULL)
+				v = other;
+		}
+		else if (other->n == n)
+		{
+			v = other;
+			break;
+		}
+		else if (victim == NULL || other->priority < victim->priority ||
+			(other->priority == victim->priority && (u16)(audio_frame - other->start) > (u16)(audio_frame - victim->start)))
+		{
+			victim = other;
+		}
+	}
+
+	if (v == NULL)
+		v = victim;
+
+	if (v->handle != 0)
+	{
+		if (v->priority > priority)
+		{
+			sfx_counts.dropped += 1;
+			return;
+		}
+		if (v->n != n)
+			sfx_counts.stolen += 1;
+		mmEffectCancel(v->handle);
+	}
+
+	v->handle = mmEffect(sfx_map[n]);
+	v->n = n;
+	v->priority = priority;
+	v->start = audio_frame;
+	sfx_last[n] = audio_frame;
+
+	if (v->handle != 0)
+		sfx_counts.played += 1;
+	else
+		sfx_counts.dropped += 1;
+}
+
+s8 current_music()
+{
+	return music_current;
+}
+
+const Sfx_Stats* sfx_stats()
+{
+	return &sfx_frame_stats;
+}
+
+
+//-- Persistence --
+//-----------------
+//lets emulators and flashcarts know the cartridge has battery backed sram
+static const char sram_id[] __attribute__((used)) ALIGN(4) = "SRAM_V113";
+
+void sram_read(u16 offset, void* dst, u16 len)
+{
+	//sram is on an 8 bit bus
+	vu8* sram = (vu8*)SRAM + offset;
+	u8* d = dst;
+	for (u16 i = 0; i < len; i++)
+		d[i] = sram[i];
+}
+
+void sram_write(u16 offset, const void* src, u16 len)
+{
+	vu8* sram = (vu8*)SRAM + offset;
+	const u8* s = src;
+	for (u16 i = 0; i < len; i++)
+		sram[i] = s[i];
+}
+
+
+//-- Profiling --
+//---------------
+#ifdef COST_MODEL
+THREAD_LOCAL u32 cost_counts[COSTS];
+#endif
+
+#ifdef DIVCOUNT
+volatile u32 div_calls = 0;
+
+//the divmod routines return the quotient in r0 and the remainder in r1
+s32 __real___aeabi_idiv(s32 a, s32 b);
+u32 __real___aeabi_uidiv(u32 a, u32 b);
+u64 __real___aeabi_idivmod(s32 a, s32 b);
+u64 __real___aeabi_uidivmod(u32 a, u32 b);
+float __real___aeabi_fdiv(float a, float b);
+
+s32 __wrap___aeabi_idiv(s32 a, s32 b) { div_calls += 1; return __real___aeabi_idiv(a, b); }
+u32 __wrap___aeabi_uidiv(u32 a, u32 b) { div_calls += 1; return __real___aeabi_uidiv(a, b); }
+u64 __wrap___aeabi_idivmod(s32 a, s32 b) { div_calls += 1; return __real___aeabi_idivmod(a, b); }
+u64 __wrap___aeabi_uidivmod(u32 a, u32 b) { div_calls += 1; return __real___aeabi_uidivmod(a, b); }
+float __wrap___aeabi_fdiv(float a, float b) { div_calls += 1; return __real___aeabi_fdiv(a, b); }
+#endif
+
+void init_cycles()
+{
+	//timers 2 and 3 cascaded into a free running cpu cycle counter
+	//(maxmod uses timer 0)
+	REG_TM2CNT_H = 0;
+	REG_TM3CNT_H = 0;
+	REG_TM2CNT_L = 0;
+	REG_TM3CNT_L = 0;
+	REG_TM3CNT_H = TIMER_START | TIMER_COUNT;
+	REG_TM2CNT_H = TIMER_START;
+}
+
+u32 cycles()
+{
+	u16 hi, lo;
+	do {
+		hi = REG_TM3CNT_L;
+		lo = REG_TM2CNT_L;
+	} while (hi != REG_TM3CNT_L);
+
+	return (hi << 16) | lo;
 }
 
 
 //-- Math --
 //----------
+//xorshift, so the state can be saved and restored with the game
+THREAD_LOCAL u32 rnd_seed = 1;
+
+static int next_rand()
+{
+	rnd_seed ^= rnd_seed << 13;
+	rnd_seed ^= rnd_seed >> 17;
+	rnd_seed ^= rnd_seed << 5;
+	return rnd_seed >> 1;
+}
+
 int rndi(int x)
 {
-	return (rand() % x);
+	//most calls ask for a power of two, those need no division
+	if ((x & (x-1)) == 0)
+		return next_rand() & (x-1);
+	return (next_rand() % x);
 }
 
 float rnd(float x)
@@ -255,5 +814,5 @@ float rnd(float x)
 	if (v == 0)
 		return 0;
 
-	return ((rand() % v) / 100.f);
-}
\ No newline at end of file
+	return ((next_rand() % v) / 100.f);
+}
@@ -12,6 +12,13 @@ extern const unsigned char FLAGS_DATA[FLAGS_SIZE];
 #define MAP_SIZE 8192
 extern const unsigned short MAP_DATA[MAP_SIZE];
 
+//state of a running game, one copy per thread in the host tools
+#ifdef HOST
+#define THREAD_LOCAL _Thread_local
+#else
+#define THREAD_LOCAL
+#endif
+
 
 //-- Graphics --
 //--------------
@@ -20,21 +27,112 @@ extern const unsigned short MAP_DATA[MAP_SIZE];
 #define PAL_PLAYER 	(1 << 2)
 #define PAL_TEXT  	(1 << 3)
 #define PAL_OVERLAY (1 << 4)
+#define PAL_TEXT2 	(1 << 5)	//text in a 2nd color in the same frame
+
+#define FADE_SCREEN ((1 << 1) | (1 << 4))	//game tiles and sprites, not the border
 
 #define fget(n,f) ((FLAGS_DATA[(n)] >> (f)) & 1)
 
 void camera(s16 x, s16 y);
 void pal(u8 c0, u8 c1, u8 p);
 void print(char const* str, u8 x, u8 y, u8 col);
+void print2(char const* str, u8 x, u8 y, u8 col);	//with PAL_TEXT2
 void rectfill(u8 x, u8 y, u8 w, u8 h, s8 col);
+void winfill(u8 x, u8 y, u8 w, u8 h, s8 col);	//no sprites show on it
+void fade(s8 level, u8 layers);	//-16 black to 16 white, for this frame
 void spr(u16 n, s16 x, s16 y, u8 layer, u8 palette, bool flip_x, bool flip_y);
-void update_screen();
+void update_screen();	//the frame is done, shown when its 2 vblanks are over
+void screen_vblank();
+u32 screen_vblank_cost();	//cycles of the last frame shown
+
+
+//-- Frame timing --
+//------------------
+//a game frame gets two vblanks and waits only once, before it starts: the
+//update and draw run back to back, update_audio() is called for each vblank
+//in between
+void frame_vblank();	//from the vblank interrupt, before screen_vblank()
+void frame_wait();	//until the next game frame is due
+void frame_audio();	//update_audio() when a vblank went by since the last one
+
+
+//-- Parallax --
+//--------------
+//bands are 8 pixel rows of the screen, layer 0 is bg2 and 1 is bg3
+#define PARALLAX_BANDS 20
+
+void parallax_band(u8 layer, u8 band, u8 x);	//shown from the next update_screen()
+void parallax_vblank();
 
 
 //-- Audio --
 //-----------
+//mixing rate in khz and channel counts are set by the makefile
+#ifndef MIX_RATE
+#define MIX_RATE 16
+#endif
+
+#ifndef MUSIC_CHANNELS
+#define MUSIC_CHANNELS 8
+#endif
+
+#ifndef SFX_CHANNELS
+#define SFX_CHANNELS 4
+#endif
+
+//sfx() calls over the last frame
+typedef struct
+{
+	u8 requested;
+	u8 played;
+	u8 deduped;	//same effect retriggered too soon
+	u8 dropped;	//no voice of equal or lower priority free
+	u8 stolen;	//another effect cut off for this one
+	u8 voices;	//voices still playing
+} Sfx_Stats;
+
+void init_audio();
+void update_audio();
 void music(s8 n, u16 fade_len, u8 channel_mask);
 void sfx(u8 n);
+s8 current_music();	//-1 when stopped or fading out
+const Sfx_Stats* sfx_stats();
+
+
+//-- Persistence --
+//-----------------
+void sram_read(u16 offset, void* dst, u16 len);
+void sram_write(u16 offset, const void* src, u16 len);
+
+
+//-- Profiling --
+//---------------
+#define CYCLES_PER_FRAME 280896
+
+void init_cycles();
+u32 cycles();
+
+#ifdef DIVCOUNT
+//calls of the libgcc division routines, through the linker's --wrap
+extern volatile u32 div_calls;
+#endif
+
+//calls of the primitives most of a frame goes to, counted for the host
+//fuzzer's cost model (-DCOST_MODEL) and compiled out everywhere else
+enum
+{
+	COST_SPR,
+	COST_TILE_FLAG,
+	COST_SOLID,
+	COSTS
+};
+
+#ifdef COST_MODEL
+extern THREAD_LOCAL u32 cost_counts[COSTS];
+#define cost_count(c) (cost_counts[(c)] += 1)
+#else
+#define cost_count(c)
+#endif
 
 
 //-- Math --
@@ -44,6 +142,18 @@ void sfx(u8 n);
 
 #define flr(X) ((s16)(X))
 
+//division by small constants as a multiply and shift, exact below 65536.
+//thumb code has no long multiply, so gcc calls __aeabi_uidiv for n/3.
+static inline u32 div3(u32 n) { return (n*43691) >> 17; }
+static inline u32 div5(u32 n) { return (n*52429) >> 18; }
+static inline u32 div10(u32 n) { return (n*52429) >> 19; }
+static inline u32 mod3(u32 n) { return n - div3(n)*3; }
+static inline u32 mod5(u32 n) { return n - div5(n)*5; }
+static inline u32 mod10(u32 n) { return n - div10(n)*10; }
+static inline u32 mod360(u32 n) { return n - ((n*11651) >> 22)*360; }
+
+extern THREAD_LOCAL u32 rnd_seed;
+
 int rndi(int x);	//integer rand (fast)
 float rnd(float x);	//float rand (slow)
 
@@ -0,0 +1,287 @@
+//encodes the sfx wavs as 4 bit ima adpcm for the ADPCM=1 rom and reports
+//the rom saved against the 8 bit samples mmutil stores, and the quality of
+//both (signal to noise against the 16 bit wav, decoded with the rom's own
+//decoder).
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gba_types.h>
+#include "adpcm.h"
+
+#define MAX_CLIPS 64
+
+
+//-- wav files --
+//---------------
+typedef struct
+{
+	s16* samples;
+	u32 count;
+	u32 rate;
+} Wav;
+
+static u32 le32(const u8* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24); }
+static u16 le16(const u8* p) { return p[0] | (p[1] << 8); }
+
+//16 bit mono pcm only, that's what maxmod_data holds
+static bool wav_read(const char* path, Wav* wav)
+{
+	FILE* f = fopen(path, "rb");
+	if (f == NULL)
+		return false;
+
+	fseek(f, 0, SEEK_END);
+	long len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	u8* buf = malloc(len);
+	bool ok = fread(buf, 1, len, f) == (size_t)len;
+	fclose(f);
+
+	if (!ok || len < 12 || memcmp(buf, "RIFF", 4) || memcmp(buf+8, "WAVE", 4))
+	{
+		free(buf);
+		return false;
+	}
+
+	bool fmt_ok = false;
+	wav->samples = NULL;
+	for (long pos = 12; pos+8 <= len; )
+	{
+		u32 size = le32(buf+pos+4);
+		const u8* chunk = buf+pos+8;
+		if (pos+8+size > (u32)len)
+			break;
+
+		if (memcmp(buf+pos, "fmt ", 4) == 0 && size >= 16)
+		{
+			wav->rate = le32(chunk+4);
+			fmt_ok = le16(chunk) == 1 && le16(chunk+2) == 1 && le16(chunk+14) == 16;
+		}
+		else if (memcmp(buf+pos, "data", 4) == 0 && fmt_ok)
+		{
+			wav->count = size/2;
+			wav->samples = malloc(size);
+			for (u32 i = 0; i < wav->count; i++)
+				wav->samples[i] = (s16)le16(chunk + i*2);
+		}
+		pos += 8 + size + (size & 1);
+	}
+
+	free(buf);
+	return wav->samples != NULL;
+}
+
+
+//-- encoder --
+//-------------
+static const u16 steps[89] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+	253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+	1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+	3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+	11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+	32767
+};
+
+static const s8 indices[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+typedef struct
+{
+	s32 predictor;
+	s32 index;
+} Codec;
+
+//the decoder's step for one nibble
+static void codec_step(Codec* c, u8 nibble)
+{
+	s32 step = steps[c->index];
+	s32 diff = step >> 3;
+	if (nibble & 4) diff += step;
+	if (nibble & 2) diff += step >> 1;
+	if (nibble & 1) diff += step >> 2;
+
+	c->predictor += (nibble & 8)? -diff: diff;
+	c->predictor = (c->predictor > 32767)? 32767: (c->predictor < -32768)? -32768: c->predictor;
+	c->index += indices[nibble & 7];
+	c->index = (c->index < 0)? 0: (c->index > 88)? 88: c->index;
+}
+
+//smallest squared error of the next depth samples from this state, the
+//square and saw waves of the sfx jump faster than the step size adapts and
+//the usual greedy encoder overshoots for many samples after every edge
+static s64 search(const Codec* c, const s16* samples, u32 left, u8 depth, u8* best)
+{
+	if (depth == 0 || left == 0)
+		return 0;
+
+	s64 best_err = -1;
+	for (u8 nibble = 0; nibble < 16; nibble++)
+	{
+		Codec next = *c;
+		codec_step(&next, nibble);
+
+		s64 e = samples[0] - next.predictor;
+		e = e*e + search(&next, samples+1, left-1, depth-1, NULL);
+		if (best_err < 0 || e < best_err)
+		{
+			best_err = e;
+			if (best)
+				*best = nibble;
+		}
+	}
+	return best_err;
+}
+
+static u8 lookahead = 3;
+
+//header and nibbles of one clip, returns its size
+static u32 encode(const Wav* wav, u8* out)
+{
+	Adpcm_Header* header = (Adpcm_Header*)out;
+	u8* data = (u8*)(header+1);
+	Codec c = { (wav->count > 0)? wav->samples[0]: 0, 0 };
+
+	header->samples = wav->count;
+	header->predictor = c.predictor;
+	header->index = c.index;
+	header->pad = 0;
+
+	memset(data, 0, (wav->count+1)/2);
+	for (u32 i = 0; i < wav->count; i++)
+	{
+		u8 nibble = 0;
+		search(&c, &wav->samples[i], wav->count-i, lookahead, &nibble);
+		codec_step(&c, nibble);
+		data[i/2] |= (i & 1)? nibble << 4: nibble;
+	}
+
+	return (sizeof(Adpcm_Header) + (wav->count+1)/2 + 3) & ~3;
+}
+
+//signal to noise of 8 bit samples against the 16 bit source, in db
+static double snr(const Wav* wav, const s8* decoded)
+{
+	double signal = 0, noise = 0;
+	for (u32 i = 0; i < wav->count; i++)
+	{
+		double s = wav->samples[i];
+		double e = s - decoded[i]*256.0;
+		signal += s*s;
+		noise += e*e;
+	}
+	return (noise > 0)? 10*log10(signal/noise): 99;
+}
+
+
+//-- main --
+//----------
+static void usage()
+{
+	printf("usage: adpcm [-o bank.bin] [-l samples] sndN.wav...\n");
+	printf("  -o  write the clips as a bank for the rom\n");
+	printf("  -l  samples the encoder looks ahead, 1-4 (default 3, each one is 16x slower)\n");
+}
+
+int main(int argc, char** argv)
+{
+	const char* bank_path = NULL;
+	const char* files[MAX_CLIPS];
+	u32 clips = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-o") == 0 && i+1 < argc)
+			bank_path = argv[++i];
+		else if (strcmp(argv[i], "-l") == 0 && i+1 < argc)
+		{
+			s32 depth = atoi(argv[++i]);
+			lookahead = (depth < 1)? 1: (depth > 4)? 4: depth;
+		}
+		else if (argv[i][0] != '-' && clips < MAX_CLIPS)
+			files[clips++] = argv[i];
+		else
+		{
+			usage();
+			return 1;
+		}
+	}
+
+	if (clips == 0)
+	{
+		usage();
+		return 1;
+	}
+
+	u8* clip_data[MAX_CLIPS];
+	u32 clip_size[MAX_CLIPS];
+	u64 pcm_total = 0, adpcm_total = 0;
+
+	printf("%-10s %8s %8s %8s %8s %8s\n", "sample", "samples", "pcm8", "adpcm", "pcm8 db", "adpcm db");
+	for (u32 c = 0; c < clips; c++)
+	{
+		Wav wav;
+		if (!wav_read(files[c], &wav))
+		{
+			fprintf(stderr, "%s: not a 16 bit mono wav\n", files[c]);
+			return 1;
+		}
+
+		clip_data[c] = calloc(1, sizeof(Adpcm_Header) + wav.count/2 + 4);
+		clip_size[c] = encode(&wav, clip_data[c]);
+
+		//decoded with the rom's decoder, and plain 8 bit like mmutil
+		s8* decoded = malloc(wav.count + 1);
+		s8* pcm = malloc(wav.count + 1);
+		u32 bank[2] = { 1, sizeof(bank) };
+		u8* one = malloc(sizeof(bank) + clip_size[c]);
+		memcpy(one, bank, sizeof(bank));
+		memcpy(one + sizeof(bank), clip_data[c], clip_size[c]);
+
+		Adpcm_Voice v;
+		adpcm_start(&v, one, 0);
+		adpcm_decode(&v, decoded, wav.count);
+		for (u32 i = 0; i < wav.count; i++)
+			pcm[i] = wav.samples[i] >> 8;
+
+		const char* name = strrchr(files[c], '/');
+		name = name? name+1: files[c];
+		printf("%-10s %8u %8u %8u %8.1f %8.1f\n", name, wav.count, wav.count, clip_size[c], snr(&wav, pcm), snr(&wav, decoded));
+
+		pcm_total += wav.count;
+		adpcm_total += clip_size[c];
+		free(one);
+		free(pcm);
+		free(decoded);
+		free(wav.samples);
+	}
+
+	adpcm_total += 4 + clips*4;
+	printf("%-10s %8s %8llu %8llu\n", "total", "", (unsigned long long)pcm_total, (unsigned long long)adpcm_total);
+	printf("rom saved: %llu bytes (%.0f%%)\n", (unsigned long long)(pcm_total - adpcm_total),
+		100.0 * (pcm_total - adpcm_total) / pcm_total);
+
+	if (bank_path)
+	{
+		FILE* f = fopen(bank_path, "wb");
+		if (f == NULL)
+			return 1;
+
+		u32 offset = 4 + clips*4;
+		u32 n = clips;
+		fwrite(&n, 4, 1, f);
+		for (u32 c = 0; c < clips; c++)
+		{
+			fwrite(&offset, 4, 1, f);
+			offset += clip_size[c];
+		}
+		for (u32 c = 0; c < clips; c++)
+			fwrite(clip_data[c], 1, clip_size[c], f);
+		if (fclose(f) != 0)
+			return 1;
+	}
+
+	return 0;
+}
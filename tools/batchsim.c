@@ -0,0 +1,221 @@
+//runs many games at once from the same savestate, each with its own input
+//sequence, and reports the combined speed and the fastest way out of the
+//room. every thread has its own game (g), engine state and memory.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define main celeste_main
+#include "main.c"
+#undef main
+
+#include "host.h"
+#include "sim.h"
+
+#define CHUNK 16
+
+
+//-- options --
+//-------------
+static u32 instances = 4096;
+static u32 frames = 300;
+static u32 threads = 0;
+static u32 seed = 1;
+static u8 start_room = 0;
+
+
+//-- results --
+//-------------
+typedef struct
+{
+	u32 frames;	//frames simulated
+	u32 exit;	//frame the room was left on, 0 if it wasn't
+	u16 deaths;
+} Result;
+
+static Result* results;
+
+//savestate slot of the start position, copied into every thread's sram
+static u8 start_state[sizeof(Savestate_Header) + SAVESTATE_SIZE];
+static u32 start_state_len;
+
+static atomic_uint next_instance;
+
+
+//-- simulation --
+//----------------
+//input held for 1-8 frames at a time, picked from the instance's own sequence
+static u16 next_keys(u32* lcg, u16* hold, u16 keys)
+{
+	static const u16 inputs[] = {
+		0, k_right, k_left, k_right|k_jump, k_left|k_jump, k_up|k_dash,
+		k_right|k_up|k_dash, k_left|k_up|k_dash, k_right|k_dash, k_left|k_dash,
+		k_up|k_jump, k_right|k_up|k_jump, k_down|k_dash, k_right|k_down|k_dash
+	};
+
+	if (*hold > 0)
+	{
+		(*hold)--;
+		return keys;
+	}
+
+	*lcg = *lcg*1664525 + 1013904223;
+	*hold = (*lcg >> 28) % 8;
+	return inputs[(*lcg >> 8) % (sizeof(inputs)/sizeof(inputs[0]))];
+}
+
+static u32 instance_seed(u32 i)
+{
+	return seed + i*2654435761u;
+}
+
+static void run_instance(u32 i, Result* result)
+{
+	u32 lcg = instance_seed(i);
+	u16 hold = 0;
+	u16 keys = 0;
+	Point room;
+
+	load_state();
+	room = g->room;
+	result->deaths = g->deaths;
+
+	for (result->frames = 0; result->frames < frames; )
+	{
+		keys = next_keys(&lcg, &hold, keys);
+		step(keys);
+		result->frames++;
+
+		if (g->room.x != room.x || g->room.y != room.y)
+		{
+			result->exit = result->frames;
+			break;
+		}
+	}
+
+	result->deaths = g->deaths - result->deaths;
+}
+
+static void* worker(void* arg)
+{
+	(void)arg;
+	Game game = GAME_INIT;
+	g = &game;
+
+	memcpy(host_sram, start_state, start_state_len);
+
+	while (1)
+	{
+		u32 first = atomic_fetch_add(&next_instance, CHUNK);
+		if (first >= instances)
+			break;
+
+		for (u32 i = first; i < first+CHUNK && i < instances; i++)
+			run_instance(i, &results[i]);
+	}
+
+	return NULL;
+}
+
+//stand in the room once the player spawned
+static bool make_start_state()
+{
+	if (enter_room(start_room, ROOM_DJUMP(start_room)) < 0)
+		return false;
+
+	save_state();
+
+	Savestate_Header* header = (Savestate_Header*)&host_sram[SAVESTATE_SRAM];
+	start_state_len = sizeof(Savestate_Header) + header->len;
+	memcpy(start_state, &host_sram[SAVESTATE_SRAM], start_state_len);
+	return true;
+}
+
+
+//-- report --
+//------------
+static void usage()
+{
+	printf("usage: batchsim [-n instances] [-f frames] [-t threads] [-s seed] [-r room]\n");
+	printf("  -n  games to run (default 4096)\n");
+	printf("  -f  frames per game (default 300)\n");
+	printf("  -t  threads (default one per core)\n");
+	printf("  -s  seed of the input sequences (default 1)\n");
+	printf("  -r  room to start in, 0-29 (default 0)\n");
+}
+
+int main(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (i+1 >= argc || argv[i][0] != '-')
+		{
+			usage();
+			return 1;
+		}
+
+		u32 value = strtoul(argv[++i], NULL, 0);
+		switch (argv[i-1][1])
+		{
+			case 'n': instances = max(1, value); break;
+			case 'f': frames = max(1, value); break;
+			case 't': threads = value; break;
+			case 's': seed = value; break;
+			case 'r': start_room = min(29, value); break;
+			default:
+				usage();
+				return 1;
+		}
+	}
+
+	if (threads == 0)
+		threads = max(1, sysconf(_SC_NPROCESSORS_ONLN));
+
+	if (!make_start_state())
+	{
+		printf("no player in room %u\n", start_room);
+		return 1;
+	}
+
+	results = calloc(instances, sizeof(Result));
+	pthread_t* pool = malloc(threads * sizeof(pthread_t));
+	atomic_init(&next_instance, 0);
+
+	u64 start = host_ns();
+	for (u32 t = 0; t < threads; t++)
+		pthread_create(&pool[t], NULL, worker, NULL);
+	for (u32 t = 0; t < threads; t++)
+		pthread_join(pool[t], NULL);
+	u64 elapsed = host_ns() - start;
+
+	u64 total = 0;
+	u32 exits = 0, deaths = 0;
+	s32 best = -1;
+
+	for (u32 i = 0; i < instances; i++)
+	{
+		total += results[i].frames;
+		deaths += results[i].deaths;
+		if (results[i].exit)
+		{
+			exits++;
+			if (best < 0 || results[i].exit < results[best].exit)
+				best = i;
+		}
+	}
+
+	double secs = elapsed / 1e9;
+	printf("room %u, %u games of up to %u frames on %u threads\n", start_room, instances, frames, threads);
+	printf("%llu frames in %.3fs: %.0f frames/s, %.1fx realtime (30fps)\n",
+		(unsigned long long)total, secs, total / secs, total / secs / 30);
+	printf("%u games left the room, %u deaths\n", exits, deaths);
+	if (best >= 0)
+		printf("fastest: game %d (seed 0x%08x) in %u frames\n", best, instance_seed(best), results[best].exit);
+
+	free(pool);
+	free(results);
+	return 0;
+}
@@ -0,0 +1,518 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <gba_types.h>
+#include <gba_video.h>
+#include <gba_dma.h>
+
+#include "compositor.h"
+
+#define IO16(offset) (*(const u16*)(host_io + (offset)))
+
+#define TRANSPARENT 0x8000	//above every bgr555 color
+
+//blend targets and window bits are in this order
+enum
+{
+	LAYER_BG0,
+	LAYER_BG1,
+	LAYER_BG2,
+	LAYER_BG3,
+	LAYER_OBJ,
+	LAYER_BACKDROP
+};
+
+
+//palette ram with color 0 of every bank TRANSPARENT, for 16 and 256 colors
+typedef struct
+{
+	u16 bg16[256];
+	u16 bg256[256];
+	u16 obj16[256];
+	u16 obj256[256];
+} Colors;
+
+static void colors_read(Colors* colors)
+{
+	const u16* pal = (const u16*)host_pal;
+	for (u16 i = 0; i < 256; i++)
+	{
+		colors->bg16[i] = colors->bg256[i] = pal[i] & 0x7fff;
+		colors->obj16[i] = colors->obj256[i] = pal[256+i] & 0x7fff;
+		if ((i & 15) == 0)
+			colors->bg16[i] = colors->obj16[i] = TRANSPARENT;
+	}
+	colors->bg256[0] = colors->obj256[0] = TRANSPARENT;
+}
+
+
+//-- backgrounds --
+//-----------------
+//one line of a text background, TRANSPARENT where color 0 is
+static void bg_line(u8 bg, u16 y, const Colors* colors, u16* out)
+{
+	u16 cnt = IO16(0x08 + bg*2);
+	u16 hofs = IO16(0x10 + bg*4) & 0x1ff;
+	u16 vofs = IO16(0x12 + bg*4) & 0x1ff;
+	u16 width = (cnt & (1 << 14))? 512: 256;
+	u16 height = (cnt & (1 << 15))? 512: 256;
+	u32 chars = ((cnt >> 2) & 3) * 0x4000;
+	const u16* screens = (const u16*)(host_vram + ((cnt >> 8) & 31) * 0x800);
+	bool color256 = cnt & (1 << 7);
+
+	u16 py = (y + vofs) & (height-1);
+	const u16* row = screens + (py >> 8)*(width >> 8)*1024 + ((py & 255) >> 3)*32;
+
+	//whole tile rows from the one under the left edge, then the screen's part
+	u16 tiles[SCREEN_W+16];
+	u16* at_x = tiles;
+	for (u16 px = hofs & ~7; at_x < tiles+SCREEN_W+8; px = (px+8) & (width-1), at_x += 8)
+	{
+		u16 entry = row[(px >> 8)*1024 + ((px & 255) >> 3)];
+		u8 ty = (py & 7) ^ ((entry & (1 << 11))? 7: 0);
+		u8 flip = (entry & (1 << 10))? 7: 0;
+
+		//backgrounds can't reach the sprite tiles, those read as 0
+		if (color256)
+		{
+			u32 at = chars + (entry & 0x3ff)*64 + ty*8;
+			for (u8 i = 0; i < 8; i++)
+				at_x[i ^ flip] = colors->bg256[(at < 0x10000)? host_vram[at+i]: 0];
+		}
+		else
+		{
+			u32 at = chars + (entry & 0x3ff)*32 + ty*4;
+			u32 bits = (at < 0x10000)? *(const u32*)(host_vram + at): 0;
+			const u16* bank = colors->bg16 + ((entry >> 12) << 4);
+			for (u8 i = 0; i < 8; i++, bits >>= 4)
+				at_x[i ^ flip] = bank[bits & 15];
+		}
+	}
+
+	memcpy(out, tiles + (hofs & 7), SCREEN_W*sizeof(u16));
+}
+
+
+//-- sprites --
+//-------------
+//width and height by shape (square, wide, tall) and size
+static const u8 obj_sizes[3][4][2] = {
+	{ {8,8}, {16,16}, {32,32}, {64,64} },
+	{ {16,8}, {32,8}, {32,16}, {64,32} },
+	{ {8,16}, {8,32}, {16,32}, {32,64} }
+};
+
+typedef struct
+{
+	u16 color[SCREEN_W];
+	u8 prio[SCREEN_W];	//4 where no sprite is
+	bool semi[SCREEN_W];	//semi transparent, blends with what's below
+	bool window[SCREEN_W];	//inside the obj window
+	bool any_semi;
+} Obj_Line;
+
+//the sprites that show, in oam order
+typedef struct
+{
+	u8 index[128];
+	u8 count;
+} Obj_List;
+
+static void obj_list(Obj_List* list)
+{
+	const u16* oam = (const u16*)host_oam;
+
+	list->count = 0;
+	for (u8 i = 0; i < 128; i++)
+	{
+		u16 attr0 = oam[i*4];
+		bool hidden = (attr0 & (3 << 8)) == (2 << 8);
+		if (!hidden && ((attr0 >> 10) & 3) != 3 && (attr0 >> 14) != 3)
+			list->index[list->count++] = i;
+	}
+}
+
+//the frontmost sprite pixel of every column: lowest priority, then lowest
+//oam index
+static void obj_line(u16 y, const Colors* colors, const Obj_List* list, Obj_Line* line)
+{
+	const u16* oam = (const u16*)host_oam;
+	bool map_1d = IO16(0x00) & (1 << 6);
+
+	memset(line->prio, 4, sizeof(line->prio));
+	memset(line->window, 0, sizeof(line->window));
+	line->any_semi = false;
+
+	for (u8 n = 0; n < list->count; n++)
+	{
+		u8 i = list->index[n];
+		u16 attr0 = oam[i*4], attr1 = oam[i*4+1], attr2 = oam[i*4+2];
+		bool affine = attr0 & (1 << 8);
+		bool twice = affine && (attr0 & (1 << 9));
+		u8 mode = (attr0 >> 10) & 3;
+		u8 shape = attr0 >> 14;
+
+		s16 w = obj_sizes[shape][attr1 >> 14][0];
+		s16 h = obj_sizes[shape][attr1 >> 14][1];
+		s16 bw = twice? w*2: w;
+		s16 bh = twice? h*2: h;
+
+		//y wraps at 256, x at 512
+		s16 row = (y - (attr0 & 0xff)) & 0xff;
+		if (row >= bh)
+			continue;
+		s16 ox = attr1 & 0x1ff;
+		if (ox >= SCREEN_W)
+			ox -= 512;
+
+		bool color256 = attr0 & (1 << 13);
+		u16 tile = attr2 & 0x3ff;
+		u8 prio = (attr2 >> 10) & 3;
+		u8 palette = attr2 >> 12;
+
+		//8.8 matrix from screen to texture, centered on the sprite
+		s32 pa = 256, pb = 0, pc = 0, pd = 256;
+		if (affine)
+		{
+			const u16* m = oam + ((attr1 >> 9) & 31)*16;
+			pa = (s16)m[3];
+			pb = (s16)m[7];
+			pc = (s16)m[11];
+			pd = (s16)m[15];
+		}
+		s32 dy = row - bh/2;
+
+		for (s16 c = 0; c < bw; c++)
+		{
+			s16 x = ox + c;
+			if (x < 0 || x >= SCREEN_W)
+				continue;
+
+			s32 tx, ty;
+			if (affine)
+			{
+				s32 dx = c - bw/2;
+				tx = ((pa*dx + pb*dy) >> 8) + w/2;
+				ty = ((pc*dx + pd*dy) >> 8) + h/2;
+				if (tx < 0 || tx >= w || ty < 0 || ty >= h)
+					continue;
+			}
+			else
+			{
+				tx = (attr1 & (1 << 12))? w-1-c: c;
+				ty = (attr1 & (1 << 13))? h-1-row: row;
+			}
+
+			//tiles are numbered in 32 byte steps in both color depths
+			u16 color;
+			if (color256)
+			{
+				u32 t = tile + (map_1d? ((ty/8)*(w/8) + tx/8)*2: (ty/8)*32 + (tx/8)*2);
+				color = colors->obj256[host_vram[0x10000 + ((t*32 + (ty & 7)*8 + (tx & 7)) & 0x7fff)]];
+			}
+			else
+			{
+				u32 t = tile + (map_1d? (ty/8)*(w/8) + tx/8: (ty/8)*32 + tx/8);
+				u8 bits = host_vram[0x10000 + ((t*32 + (ty & 7)*4 + (tx & 7)/2) & 0x7fff)];
+				color = colors->obj16[(palette << 4) | ((bits >> ((tx & 1)*4)) & 15)];
+			}
+
+			if (color == TRANSPARENT)
+				continue;
+			if (mode == 2)
+			{
+				line->window[x] = true;
+				continue;
+			}
+			if (prio < line->prio[x])
+			{
+				line->color[x] = color;
+				line->prio[x] = prio;
+				line->semi[x] = mode == 1;
+				line->any_semi |= mode == 1;
+			}
+		}
+	}
+}
+
+
+//-- effects --
+//-------------
+static u8 coefficient(u16 bits)
+{
+	return (bits > 16)? 16: bits;
+}
+
+static u16 blend(u16 a, u16 b, u8 eva, u8 evb)
+{
+	u16 out = 0;
+	for (u8 shift = 0; shift < 15; shift += 5)
+	{
+		u16 c = (((a >> shift) & 31)*eva + ((b >> shift) & 31)*evb) >> 4;
+		out |= ((c > 31)? 31: c) << shift;
+	}
+	return out;
+}
+
+static u16 brightness(u16 a, u8 evy, bool up)
+{
+	u16 out = 0;
+	for (u8 shift = 0; shift < 15; shift += 5)
+	{
+		u16 c = (a >> shift) & 31;
+		c = up? c + (((31-c)*evy) >> 4): c - ((c*evy) >> 4);
+		out |= c << shift;
+	}
+	return out;
+}
+
+//start and end in the high and low byte, end excluded. start past end
+//wraps around the screen edge.
+static bool in_window(u16 v, u16 reg)
+{
+	u8 start = reg >> 8, end = reg & 0xff;
+	return (start <= end)? (v >= start && v < end): (v >= start || v < end);
+}
+
+static void window_span(u8* masks, u16 reg, u8 mask)
+{
+	for (u16 x = 0; x < SCREEN_W; x++)
+	{
+		if (in_window(x, reg))
+			masks[x] = mask;
+	}
+}
+
+
+//-- lines --
+//-----------
+static void draw_line(u16 y, u16 dispcnt, const Colors* colors, const Obj_List* list, u16* out)
+{
+	u16 bgs[4][SCREEN_W];
+	u8 order[4], prios[4], count = 0;
+	Obj_Line obj;
+
+	//enabled backgrounds, front to back
+	for (u8 prio = 0; prio < 4; prio++)
+	{
+		for (u8 bg = 0; bg < 4; bg++)
+		{
+			if (!(dispcnt & (BG0_ON << bg)) || (IO16(0x08 + bg*2) & 3) != prio)
+				continue;
+
+			bg_line(bg, y, colors, bgs[bg]);
+			order[count] = bg;
+			prios[count++] = prio;
+		}
+	}
+
+	bool objs = dispcnt & OBJ_ON;
+	if (objs)
+		obj_line(y, colors, list, &obj);
+
+	//layers and effects the windows let through, win0 over win1 over the
+	//obj window over the outside
+	u8 masks[SCREEN_W];
+	if (dispcnt & (WIN0_ON | WIN1_ON | OBJ_WIN_ON))
+	{
+		u16 winin = IO16(0x48), winout = IO16(0x4a);
+
+		memset(masks, winout & 0x3f, sizeof(masks));
+		if ((dispcnt & OBJ_WIN_ON) && objs)
+		{
+			for (u16 x = 0; x < SCREEN_W; x++)
+			{
+				if (obj.window[x])
+					masks[x] = (winout >> 8) & 0x3f;
+			}
+		}
+		if ((dispcnt & WIN1_ON) && in_window(y, IO16(0x46)))
+			window_span(masks, IO16(0x42), (winin >> 8) & 0x3f);
+		if ((dispcnt & WIN0_ON) && in_window(y, IO16(0x44)))
+			window_span(masks, IO16(0x40), winin & 0x3f);
+	}
+	else
+		memset(masks, 0x3f, sizeof(masks));
+
+	u16 bldcnt = IO16(0x50);
+	u8 effect = (bldcnt >> 6) & 3;
+	u8 eva = coefficient(IO16(0x52) & 31);
+	u8 evb = coefficient((IO16(0x52) >> 8) & 31);
+	u8 evy = coefficient(IO16(0x54) & 31);
+	u16 backdrop = ((const u16*)host_pal)[0] & 0x7fff;
+
+	//nothing blends or fades on this line: paint the layers back to front
+	if (effect == 0 && !(objs && obj.any_semi))
+	{
+		for (u16 x = 0; x < SCREEN_W; x++)
+			out[x] = backdrop;
+
+		s8 next = count-1;
+		for (s8 prio = 3; prio >= 0; prio--)
+		{
+			for (; next >= 0 && prios[next] == prio; next--)
+			{
+				const u16* line = bgs[order[next]];
+				u8 bit = 1 << order[next];
+				for (u16 x = 0; x < SCREEN_W; x++)
+					out[x] = (line[x] != TRANSPARENT && (masks[x] & bit))? line[x]: out[x];
+			}
+			if (!objs)
+				continue;
+			for (u16 x = 0; x < SCREEN_W; x++)
+				out[x] = (obj.prio[x] == prio && (masks[x] & (1 << LAYER_OBJ)))? obj.color[x]: out[x];
+		}
+		return;
+	}
+
+	//only alpha blends look under the frontmost layer
+	u8 need = (effect == 1 || (objs && obj.any_semi))? 2: 1;
+
+	for (u16 x = 0; x < SCREEN_W; x++)
+	{
+		u8 mask = masks[x];
+
+		//the frontmost layers, sprites go over backgrounds of the same
+		//priority
+		u16 color[2] = { backdrop, backdrop };
+		u8 layer[2] = { LAYER_BACKDROP, LAYER_BACKDROP };
+		u8 found = 0, next = 0;
+		u8 obj_prio = (objs && (mask & (1 << LAYER_OBJ)))? obj.prio[x]: 4;
+
+		while (found < need)
+		{
+			if (obj_prio < 4 && (next >= count || obj_prio <= prios[next]))
+			{
+				color[found] = obj.color[x];
+				layer[found++] = LAYER_OBJ;
+				obj_prio = 4;
+			}
+			else if (next < count)
+			{
+				u8 bg = order[next++];
+				if (bgs[bg][x] != TRANSPARENT && (mask & (1 << bg)))
+				{
+					color[found] = bgs[bg][x];
+					layer[found++] = bg;
+				}
+			}
+			else
+				break;
+		}
+
+		u16 pixel = color[0];
+		if (mask & (1 << 5))
+		{
+			bool second = bldcnt & (1 << (8 + layer[1]));
+			if (layer[0] == LAYER_OBJ && obj.semi[x] && second)
+				pixel = blend(color[0], color[1], eva, evb);
+			else if (bldcnt & (1 << layer[0]))
+			{
+				if (effect == 1 && second)
+					pixel = blend(color[0], color[1], eva, evb);
+				else if (effect == 2 || effect == 3)
+					pixel = brightness(color[0], evy, effect == 2);
+			}
+		}
+		out[x] = pixel;
+	}
+}
+
+//repeating hblank transfers after every line. the channel restarts from its
+//registers when it's enabled, which happens in vblank before this frame,
+//so the addresses it has reached live here.
+static void hblank_dma(uintptr_t* src, uintptr_t* dst)
+{
+	for (u8 ch = 0; ch < 4; ch++)
+	{
+		volatile Host_Dma* dma = &(host_dma[ch]);
+		u32 cnt = dma->cnt;
+		if (!(cnt & DMA_ENABLE) || (cnt & (3 << 28)) != DMA_HBLANK)
+			continue;
+
+		//a count of 0 (the full 16k) isn't done
+		u8 size = (cnt & DMA32)? 4: 2;
+		u8 src_mode = (cnt >> 23) & 3, dst_mode = (cnt >> 21) & 3;
+		s8 src_step = (src_mode == 0)? size: (src_mode == 1)? -size: 0;
+		s8 dst_step = (dst_mode == 1)? -size: (dst_mode == 2)? 0: size;
+
+		for (u32 i = 0; i < (cnt & 0xffff); i++)
+		{
+			memcpy((void*)dst[ch], (const void*)src[ch], size);
+			src[ch] += src_step;
+			dst[ch] += dst_step;
+		}
+
+		if (dst_mode == 3)
+			dst[ch] = dma->dad;
+		if (!(cnt & DMA_REPEAT))
+			dma->cnt = cnt & ~DMA_ENABLE;
+	}
+}
+
+void composite(u16* pixels)
+{
+	Colors colors;
+	Obj_List list;
+	colors_read(&colors);
+	obj_list(&list);
+
+	uintptr_t src[4], dst[4];
+	for (u8 ch = 0; ch < 4; ch++)
+	{
+		src[ch] = host_dma[ch].sad;
+		dst[ch] = host_dma[ch].dad;
+	}
+
+	for (u16 y = 0; y < SCREEN_H; y++)
+	{
+		u16* out = pixels + y*SCREEN_W;
+		u16 dispcnt = IO16(0x00);
+
+		//forced blank is white, the bitmap modes aren't drawn
+		if ((dispcnt & (1 << 7)) || (dispcnt & 7) != 0)
+		{
+			u16 fill = (dispcnt & (1 << 7))? 0x7fff: ((const u16*)host_pal)[0] & 0x7fff;
+			for (u16 x = 0; x < SCREEN_W; x++)
+				out[x] = fill;
+		}
+		else
+			draw_line(y, dispcnt, &colors, &list, out);
+
+		hblank_dma(src, dst);
+	}
+}
+
+
+//-- output --
+//------------
+u64 frame_hash(const u16* pixels)
+{
+	u64 h = 0xcbf29ce484222325ull;
+	for (u32 i = 0; i < SCREEN_W*SCREEN_H; i += 4)
+	{
+		u64 word;
+		memcpy(&word, &pixels[i], 8);
+		h = (h ^ word) * 0x100000001b3ull;
+		h ^= h >> 29;
+	}
+	return h;
+}
+
+bool frame_write_ppm(const char* path, const u16* pixels)
+{
+	FILE* f = fopen(path, "wb");
+	if (f == NULL)
+		return false;
+
+	fprintf(f, "P6\n%d %d\n255\n", SCREEN_W, SCREEN_H);
+	for (u32 i = 0; i < SCREEN_W*SCREEN_H; i++)
+	{
+		for (u8 shift = 0; shift < 15; shift += 5)
+		{
+			u8 c = (pixels[i] >> shift) & 31;
+			fputc((c << 3) | (c >> 2), f);
+		}
+	}
+	return fclose(f) == 0;
+}
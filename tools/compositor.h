@@ -0,0 +1,22 @@
+//the gba screen in software: mode 0 (four text backgrounds, sprites with
+//affine matrices, windows, blending and brightness) drawn from the host's
+//copies of vram, palette ram, oam and the io registers, after the vblank
+//commits like the lcd would show it
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <gba_types.h>
+
+#define SCREEN_W 240
+#define SCREEN_H 160
+
+//one frame in bgr555, runs the hblank dma between the lines
+void composite(u16* pixels);
+
+//64 bit hash of a frame, four pixels a step
+u64 frame_hash(const u16* pixels);
+
+//binary ppm, false when it can't be written
+bool frame_write_ppm(const char* path, const u16* pixels);
+
+#endif
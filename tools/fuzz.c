@@ -0,0 +1,450 @@
+//searches every room for the input sequence with the costliest frame. a
+//frame is costed by counting the calls of the primitives most of a gba
+//frame goes to (spr, tile_flag_at, is_solid, -DCOST_MODEL) weighted by
+//rough cycles per call. sequences that reach a new coverage feature or a
+//costlier frame join the room's corpus and are mutated further, the worst
+//one is written as a replay. one room per thread at a time.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define main celeste_main
+#include "main.c"
+#undef main
+
+#include "host.h"
+#include "sim.h"
+
+#define ROOMS 30	//like the other tools, the summit and title are left out
+#define MAX_FRAMES 600
+#define MAX_CORPUS 256
+#define COVERAGE_BITS 16
+
+
+//-- options --
+//-------------
+static s8 only_room = -1;
+static u32 iterations = 3000;
+static u32 frames = 150;
+static u32 threads = 0;
+static u32 seed = 1;
+static const char* out_dir = ".";
+static const char* play_path = NULL;
+
+
+//-- cost model --
+//----------------
+//rough gba cycles per call: a sprite into the oam copy, a flag scan of up
+//to four tiles, and is_solid's platform and fake wall checks on top of the
+//tile scan it counts separately
+static const u32 cost_weights[COSTS] = { 40, 120, 90 };
+static const char* const cost_names[COSTS] = { "spr", "tile_flag_at", "is_solid" };
+
+static u32 frame_cost()
+{
+	u32 cost = 0;
+	for (u8 i = 0; i < COSTS; i++)
+		cost += cost_counts[i] * cost_weights[i];
+	return cost;
+}
+
+//0, 1, 2-3, 4-7... like the hit counts of a coverage fuzzer
+static u8 bucket(u32 n)
+{
+	u8 b = 0;
+	while (n > 0 && b < 15)
+	{
+		n >>= 1;
+		b++;
+	}
+	return b;
+}
+
+//what the frame did: where the player is, how it moves and how many
+//calls of each primitive it made
+static u32 frame_feature()
+{
+	Player* p = &(g->player);
+	u32 h = p->obj.active;
+
+	if (p->obj.active)
+	{
+		h = h*31 + (u8)(p->obj.x/8);
+		h = h*31 + (u8)(p->obj.y/8);
+		h = h*31 + p->djump;
+		h = h*31 + (p->dash_time > 0);
+		h = h*31 + (p->grace > 0);	//on the ground or just off it
+	}
+	for (u8 i = 0; i < COSTS; i++)
+		h = h*31 + bucket(cost_counts[i]);
+	h = h*31 + g->fx.count[fx_smoke];
+
+	h ^= h >> 16;
+	h *= 0x45d9f3b;
+	h ^= h >> 16;
+	return h & ((1 << COVERAGE_BITS)-1);
+}
+
+
+//-- runs --
+//----------
+typedef struct
+{
+	u32 worst;	//cost of the costliest frame
+	u16 worst_frame;
+	u32 counts[COSTS];	//of that frame
+	bool new_coverage;
+} Run;
+
+typedef struct
+{
+	u8 level;
+	Snapshot start;
+	u8* coverage;
+} Room_Fuzz;
+
+//plays keys from the start of the room until the frames are up or the room
+//is left
+static void run_keys(Room_Fuzz* fuzz, const u16* keys, Run* run)
+{
+	Point room = { fuzz->level%8, fuzz->level/8 };
+
+	if (g->room.x != room.x || g->room.y != room.y)
+		load_room(room.x, room.y);
+	snapshot_load(&fuzz->start);
+
+	memset(run, 0, sizeof(Run));
+	for (u32 f = 0; f < frames; f++)
+	{
+		memset(cost_counts, 0, sizeof(cost_counts));
+		step(keys[f]);
+
+		u32 cost = frame_cost();
+		if (cost > run->worst)
+		{
+			run->worst = cost;
+			run->worst_frame = f;
+			memcpy(run->counts, cost_counts, sizeof(cost_counts));
+		}
+
+		if (fuzz->coverage)
+		{
+			u32 feature = frame_feature();
+			u8 bit = 1 << (feature & 7);
+			if (!(fuzz->coverage[feature >> 3] & bit))
+			{
+				fuzz->coverage[feature >> 3] |= bit;
+				run->new_coverage = true;
+			}
+		}
+
+		if (g->room.x != room.x || g->room.y != room.y)
+			break;
+	}
+}
+
+
+//-- mutation --
+//--------------
+static const u16 inputs[] = {
+	0, k_right, k_left, k_right|k_jump, k_left|k_jump, k_up|k_dash,
+	k_right|k_up|k_dash, k_left|k_up|k_dash, k_right|k_dash, k_left|k_dash,
+	k_up|k_jump, k_right|k_up|k_jump, k_down|k_dash, k_right|k_down|k_dash,
+	k_left|k_down|k_dash, k_down, k_jump, k_dash
+};
+#define INPUTS (sizeof(inputs)/sizeof(inputs[0]))
+
+static u32 next_lcg(u32* lcg)
+{
+	*lcg = *lcg*1664525 + 1013904223;
+	return *lcg >> 8;
+}
+
+//inputs held for 1-8 frames
+static void random_keys(u32* lcg, u16* keys)
+{
+	for (u32 f = 0; f < frames; )
+	{
+		u16 k = inputs[next_lcg(lcg) % INPUTS];
+		for (u32 hold = 1 + next_lcg(lcg) % 8; hold > 0 && f < frames; hold--)
+			keys[f++] = k;
+	}
+}
+
+//one to four edits: hold a new input for a while, splice in a stretch of
+//another sequence, or cut a stretch out and hold the last input at the end
+static void mutate(u32* lcg, u16* keys, u16** corpus, u32 corpus_count)
+{
+	for (u32 edits = 1 + next_lcg(lcg) % 4; edits > 0; edits--)
+	{
+		u32 at = next_lcg(lcg) % frames;
+		u32 len = 1 + next_lcg(lcg) % 16;
+		len = min(len, frames-at);
+
+		switch (next_lcg(lcg) % 3)
+		{
+			case 0:
+			{
+				u16 k = inputs[next_lcg(lcg) % INPUTS];
+				for (u32 f = at; f < at+len; f++)
+					keys[f] = k;
+				break;
+			}
+			case 1:
+			{
+				const u16* other = corpus[next_lcg(lcg) % corpus_count];
+				memcpy(&keys[at], &other[at], len*sizeof(u16));
+				break;
+			}
+			default:
+			{
+				memmove(&keys[at], &keys[at+len], (frames-at-len)*sizeof(u16));
+				u16 last = (frames > len)? keys[frames-len-1]: 0;
+				for (u32 f = frames-len; f < frames; f++)
+					keys[f] = last;
+				break;
+			}
+		}
+	}
+}
+
+
+//-- search --
+//------------
+typedef struct
+{
+	s16 spawn;	//frames from load_room() until the player could move
+	u32 corpus;
+	u32 coverage;	//features seen
+	Run worst;
+	u16 keys[MAX_FRAMES];
+} Result;
+
+static Result results[ROOMS];
+static atomic_uint room_counter;
+
+static void fuzz_room(u8 level, Result* result)
+{
+	Room_Fuzz fuzz = { level };
+	u16* corpus[MAX_CORPUS];
+	u32 corpus_count = 0;
+	u32 lcg = seed + level*2654435761u;
+	u16 keys[MAX_FRAMES];
+	Run run;
+
+	result->spawn = enter_room(level, ROOM_DJUMP(level));
+	if (result->spawn < 0)
+		return;
+	snapshot_save(&fuzz.start);
+	fuzz.coverage = calloc(1, 1 << (COVERAGE_BITS-3));
+
+	for (u32 i = 0; i < iterations; i++)
+	{
+		//a few random sequences to start from
+		if (corpus_count < 8 || next_lcg(&lcg) % 16 == 0)
+			random_keys(&lcg, keys);
+		else
+		{
+			memcpy(keys, corpus[next_lcg(&lcg) % corpus_count], frames*sizeof(u16));
+			mutate(&lcg, keys, corpus, corpus_count);
+		}
+
+		run_keys(&fuzz, keys, &run);
+		bool worse = run.worst > result->worst.worst;
+		if (worse)
+		{
+			result->worst = run;
+			memcpy(result->keys, keys, frames*sizeof(u16));
+		}
+		if (!worse && !run.new_coverage)
+			continue;
+
+		//full: replace a random entry
+		u32 slot = next_lcg(&lcg) % MAX_CORPUS;
+		if (corpus_count < MAX_CORPUS)
+		{
+			slot = corpus_count++;
+			corpus[slot] = malloc(MAX_FRAMES*sizeof(u16));
+		}
+		memcpy(corpus[slot], keys, frames*sizeof(u16));
+	}
+
+	for (u32 i = 0; i < 1u << (COVERAGE_BITS-3); i++)
+		result->coverage += __builtin_popcount(fuzz.coverage[i]);
+	result->corpus = corpus_count;
+
+	for (u32 i = 0; i < corpus_count; i++)
+		free(corpus[i]);
+	free(fuzz.coverage);
+}
+
+static void* worker(void* arg)
+{
+	(void)arg;
+	Game game = GAME_INIT;
+	g = &game;
+
+	while (1)
+	{
+		u32 level = atomic_fetch_add(&room_counter, 1);
+		if (level >= ROOMS)
+			break;
+		if (only_room >= 0 && level != (u32)only_room)
+			continue;
+
+		fuzz_room(level, &results[level]);
+	}
+
+	return NULL;
+}
+
+//the worst frame's inputs from load_room(), the room's start included
+static bool write_worst(u8 level, const Result* result)
+{
+	char path[512];
+	u32 len = result->spawn + result->worst.worst_frame + 1;
+	Replay replay = { level, ROOM_DJUMP(level), len, calloc(len, sizeof(u16)) };
+
+	memcpy(&replay.keys[result->spawn], result->keys, (result->worst.worst_frame+1)*sizeof(u16));
+	snprintf(path, sizeof(path), "%s/worst%02u.rpl", out_dir, level);
+
+	bool ok = replay_write(path, &replay);
+	free(replay.keys);
+	return ok;
+}
+
+
+//-- replays --
+//-------------
+//cost of every frame of a replay, as csv
+static int play(const char* path)
+{
+	Replay replay;
+	if (!replay_read(path, &replay))
+	{
+		printf("%s: not a replay\n", path);
+		return 1;
+	}
+
+	replay_begin(&replay);
+
+	printf("frame,keys");
+	for (u8 i = 0; i < COSTS; i++)
+		printf(",%s", cost_names[i]);
+	printf(",cost\n");
+
+	for (u32 f = 0; f < replay.frames; f++)
+	{
+		memset(cost_counts, 0, sizeof(cost_counts));
+		step(replay.keys[f]);
+
+		printf("%u,%s", f, keys_name(replay.keys[f]));
+		for (u8 i = 0; i < COSTS; i++)
+			printf(",%u", cost_counts[i]);
+		printf(",%u\n", frame_cost());
+	}
+
+	free(replay.keys);
+	return 0;
+}
+
+
+//-- report --
+//------------
+static void usage()
+{
+	printf("usage: fuzz [-r room] [-i runs] [-f frames] [-t threads] [-s seed] [-o dir] [-p replay]\n");
+	printf("  -r  only this room, 0-29 (default all)\n");
+	printf("  -i  input sequences tried per room (default 3000)\n");
+	printf("  -f  frames per sequence (default 150, at most %u)\n", MAX_FRAMES);
+	printf("  -t  threads (default one per core)\n");
+	printf("  -s  seed (default 1)\n");
+	printf("  -o  directory for the worst<room>.rpl replays (default .)\n");
+	printf("  -p  print the cost of every frame of a replay as csv instead\n");
+}
+
+int main(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (i+1 >= argc || argv[i][0] != '-')
+		{
+			usage();
+			return 1;
+		}
+
+		const char* arg = argv[++i];
+		u32 value = strtoul(arg, NULL, 0);
+		switch (argv[i-1][1])
+		{
+			case 'r': only_room = min(ROOMS-1, value); break;
+			case 'i': iterations = max(1, value); break;
+			case 'f': frames = max(1, min(MAX_FRAMES, value)); break;
+			case 't': threads = value; break;
+			case 's': seed = value; break;
+			case 'o': out_dir = arg; break;
+			case 'p': play_path = arg; break;
+			default:
+				usage();
+				return 1;
+		}
+	}
+
+	if (play_path)
+		return play(play_path);
+
+	if (threads == 0)
+		threads = max(1, sysconf(_SC_NPROCESSORS_ONLN));
+
+	pthread_t* pool = malloc(threads * sizeof(pthread_t));
+	atomic_init(&room_counter, 0);
+
+	u64 start = host_ns();
+	for (u32 t = 0; t < threads; t++)
+		pthread_create(&pool[t], NULL, worker, NULL);
+	for (u32 t = 0; t < threads; t++)
+		pthread_join(pool[t], NULL);
+	double secs = (host_ns() - start) / 1e9;
+
+	printf("%u sequences of %u frames per room in %.1fs\n", iterations, frames, secs);
+	printf("%-4s %8s %6s", "room", "cost", "frame");
+	for (u8 i = 0; i < COSTS; i++)
+		printf(" %12s", cost_names[i]);
+	printf(" %7s %8s\n", "corpus", "features");
+
+	s8 worst = -1;
+	for (u8 r = 0; r < ROOMS; r++)
+	{
+		Result* result = &(results[r]);
+		if (only_room >= 0 && r != only_room)
+			continue;
+		if (result->spawn < 0)
+		{
+			printf("%-4u no player\n", r);
+			continue;
+		}
+
+		printf("%-4u %8u %6u", r, result->worst.worst, result->worst.worst_frame);
+		for (u8 i = 0; i < COSTS; i++)
+			printf(" %12u", result->worst.counts[i]);
+		printf(" %7u %8u\n", result->corpus, result->coverage);
+
+		if (!write_worst(r, result))
+		{
+			printf("can't write to %s\n", out_dir);
+			return 1;
+		}
+		if (worst < 0 || result->worst.worst > results[worst].worst.worst)
+			worst = r;
+	}
+
+	if (worst >= 0)
+		printf("worst: room %d, frame %u after spawning (%s/worst%02d.rpl)\n", worst,
+			results[worst].worst.worst_frame, out_dir, worst);
+
+	free(pool);
+	return 0;
+}
@@ -0,0 +1,179 @@
+//plays a replay, draws every frame the way the lcd would show it (see
+//compositor.c) and hashes it. -w keeps the hashes as a golden file, -c
+//checks a run against one, so a change that must not alter the picture
+//can be verified frame by frame.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define main celeste_main
+#include "main.c"
+#undef main
+
+#include "host.h"
+#include "sim.h"
+#include "compositor.h"
+
+
+//-- golden files --
+//------------------
+//one hash per line in hex, frame 0 first
+static bool hashes_write(const char* path, const u64* hashes, u32 count)
+{
+	FILE* f = fopen(path, "w");
+	if (f == NULL)
+		return false;
+
+	for (u32 i = 0; i < count; i++)
+		fprintf(f, "%016llx\n", (unsigned long long)hashes[i]);
+	return fclose(f) == 0;
+}
+
+//returns the hashes read, -1 when the file can't be read
+static s32 hashes_read(const char* path, u64* hashes, u32 max_count)
+{
+	FILE* f = fopen(path, "r");
+	if (f == NULL)
+		return -1;
+
+	unsigned long long h;
+	u32 count = 0;
+	while (count < max_count && fscanf(f, "%llx", &h) == 1)
+		hashes[count++] = h;
+	fclose(f);
+	return count;
+}
+
+
+//-- main --
+//----------
+static void usage()
+{
+	printf("usage: golden [-w hashes | -c hashes] [-s frame] [-o frame.ppm] replay.rpl\n");
+	printf("  -w  write the hash of every frame\n");
+	printf("  -c  compare every frame against the hashes, exits with 1 on a difference\n");
+	printf("  -s  save this frame (from 0) as a ppm\n");
+	printf("  -o  where -s saves it (default frame.ppm)\n");
+}
+
+int main(int argc, char** argv)
+{
+	const char* replay_path = NULL;
+	const char* write_path = NULL;
+	const char* check_path = NULL;
+	const char* ppm_path = "frame.ppm";
+	s32 save_frame = -1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (argv[i][0] != '-')
+		{
+			replay_path = argv[i];
+			continue;
+		}
+		if (i+1 >= argc)
+		{
+			usage();
+			return 1;
+		}
+
+		const char* arg = argv[++i];
+		switch (argv[i-1][1])
+		{
+			case 'w': write_path = arg; break;
+			case 'c': check_path = arg; break;
+			case 's': save_frame = atoi(arg); break;
+			case 'o': ppm_path = arg; break;
+			default:
+				usage();
+				return 1;
+		}
+	}
+
+	Replay replay;
+	if (replay_path == NULL || (write_path && check_path))
+	{
+		usage();
+		return 1;
+	}
+	if (!replay_read(replay_path, &replay))
+	{
+		printf("%s: not a replay\n", replay_path);
+		return 1;
+	}
+
+	u64* hashes = malloc((replay.frames+1) * sizeof(u64));
+	u16* pixels = malloc(SCREEN_W*SCREEN_H * sizeof(u16));
+
+	init_video();
+	replay_begin(&replay);
+
+	//the vblank commits come before the frame is shown, like on the gba
+	u64 draw_ns = 0;
+	u64 start = host_ns();
+	for (u32 f = 0; f < replay.frames; f++)
+	{
+		step(replay.keys[f]);
+		screen_vblank();
+		parallax_vblank();
+
+		u64 t = host_ns();
+		composite(pixels);
+		hashes[f] = frame_hash(pixels);
+		draw_ns += host_ns() - t;
+
+		if ((s32)f == save_frame && !frame_write_ppm(ppm_path, pixels))
+		{
+			printf("can't write %s\n", ppm_path);
+			return 1;
+		}
+	}
+	double secs = (host_ns() - start) / 1e9;
+
+	printf("%u frames of room %u in %.3fs: %.0f frames/s, %.0f frames/s drawing alone\n",
+		replay.frames, replay.level, secs, replay.frames / secs, replay.frames / (draw_ns / 1e9));
+
+	int result = 0;
+	if (write_path && !hashes_write(write_path, hashes, replay.frames))
+	{
+		printf("can't write %s\n", write_path);
+		result = 1;
+	}
+	else if (check_path)
+	{
+		u64* golden = malloc((replay.frames+1) * sizeof(u64));
+		s32 count = hashes_read(check_path, golden, replay.frames+1);
+		if (count < 0)
+		{
+			printf("can't read %s\n", check_path);
+			result = 1;
+		}
+		else
+		{
+			s32 first = -1;
+			u32 differ = 0;
+			for (u32 f = 0; f < min((u32)count, replay.frames); f++)
+			{
+				if (hashes[f] == golden[f])
+					continue;
+				if (first < 0)
+					first = f;
+				differ++;
+			}
+
+			if (count != (s32)replay.frames)
+				printf("%s has %d frames, the replay %u\n", check_path, count, replay.frames);
+			if (differ > 0)
+				printf("%u frames differ, the first is frame %d (save it with -s %d)\n", differ, first, first);
+			else if (count == (s32)replay.frames)
+				printf("all frames match\n");
+			result = (differ > 0 || count != (s32)replay.frames)? 1: 0;
+		}
+		free(golden);
+	}
+
+	free(pixels);
+	free(hashes);
+	free(replay.keys);
+	return result;
+}
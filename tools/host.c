@@ -0,0 +1,112 @@
+#include <string.h>
+#include <time.h>
+
+#include <gba_types.h>
+#include <gba_systemcalls.h>
+#include <gba_interrupt.h>
+#include <gba_input.h>
+#include <gba_dma.h>
+#include <maxmod.h>
+
+#include "host.h"
+
+//-- memory --
+//------------
+_Thread_local unsigned char host_vram[0x18000] ALIGN(4);
+_Thread_local unsigned char host_io[0x400] ALIGN(4);
+_Thread_local unsigned char host_pal[0x400] ALIGN(4);
+_Thread_local unsigned char host_oam[0x400] ALIGN(4);
+_Thread_local unsigned char host_sram[0x10000];
+_Thread_local volatile Host_Dma host_dma[4];
+
+const unsigned char soundbank_bin[4];
+
+
+//-- bios --
+//----------
+void CpuSet(const void* source, void* dest, u32 mode)
+{
+	u32 n = mode & 0x1FFFFF;
+
+	if (mode & COPY32)
+	{
+		for (u32 i = 0; i < n; i++)
+			((u32*)dest)[i] = (mode & FILL)? *(const u32*)source: ((const u32*)source)[i];
+	}
+	else
+	{
+		for (u32 i = 0; i < n; i++)
+			((u16*)dest)[i] = (mode & FILL)? *(const u16*)source: ((const u16*)source)[i];
+	}
+}
+
+void CpuFastSet(const void* source, void* dest, u32 mode)
+{
+	CpuSet(source, dest, mode | COPY32);
+}
+
+void VBlankIntrWait(void) {}
+void IntrWait(u32 ReturnFlag, u32 flags) {}
+
+
+//-- interrupts --
+//----------------
+void irqInit(void) {}
+IntFn* irqSet(irqMASK mask, IntFn function) { return NULL; }
+void irqEnable(int mask) {}
+void irqDisable(int mask) {}
+
+
+//-- input --
+//-----------
+THREAD_LOCAL u16 host_keys = 0;
+static THREAD_LOCAL u16 host_keys_prev = 0;
+
+void scanKeys(void) { host_keys_prev = host_keys; }
+u16 keysHeld(void) { return host_keys; }
+u16 keysDown(void) { return host_keys & ~host_keys_prev; }
+u16 keysUp(void) { return ~host_keys & host_keys_prev; }
+
+
+//-- maxmod --
+//------------
+static THREAD_LOCAL mm_sfxhand next_handle = 0;
+
+void mmInitDefault(mm_addr soundbank, mm_word number_of_channels) {}
+void mmInit(mm_gba_system* setup) {}
+void mmVBlank(void) {}
+void mmFrame(void) {}
+void mmStart(mm_word id, mm_pmode mode) {}
+void mmPause(void) {}
+void mmResume(void) {}
+void mmStop(void) {}
+mm_bool mmActive(void) { return 1; }
+void mmSetModuleVolume(mm_word volume) {}
+void mmSetJingleVolume(mm_word volume) {}
+void mmSetEffectsVolume(mm_word volume) {}
+
+mm_sfxhand mmEffect(mm_word sample_ID)
+{
+	if (++next_handle == 0)
+		next_handle = 1;
+	return next_handle;
+}
+
+mm_sfxhand mmEffectEx(mm_sound_effect* sound) { return mmEffect(sound->id); }
+void mmEffectVolume(mm_sfxhand handle, mm_word volume) {}
+void mmEffectPanning(mm_sfxhand handle, mm_byte panning) {}
+void mmEffectRate(mm_sfxhand handle, mm_word rate) {}
+void mmEffectCancel(mm_sfxhand handle) {}
+void mmEffectRelease(mm_sfxhand handle) {}
+mm_bool mmEffectActive(mm_sfxhand handle) { return 0; }
+void mmEffectCancelAll(void) {}
+
+
+//-- timing --
+//------------
+u64 host_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
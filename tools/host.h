@@ -0,0 +1,14 @@
+#ifndef HOST_H
+#define HOST_H
+
+#include <gba_types.h>
+
+#include "pico8.h"
+
+//keys reported by keysHeld() on the next scanKeys()
+extern THREAD_LOCAL u16 host_keys;
+
+//monotonic clock
+u64 host_ns();
+
+#endif
@@ -0,0 +1,21 @@
+//memory regions are plain arrays on the host, one set per thread, see tools/host.c
+#ifndef _gba_base_h_
+#define _gba_base_h_
+#include <stdint.h>
+extern _Thread_local unsigned char host_vram[0x18000];
+extern _Thread_local unsigned char host_io[0x400];
+extern _Thread_local unsigned char host_pal[0x400];
+extern _Thread_local unsigned char host_oam[0x400];
+extern _Thread_local unsigned char host_sram[0x10000];
+#define REG_BASE ((uintptr_t)host_io)
+#define VRAM ((uintptr_t)host_vram)
+#define PALRAM ((uintptr_t)host_pal)
+#define SRAM ((uintptr_t)host_sram)
+#define ALIGN(m) __attribute__((aligned (m)))
+#define IWRAM_CODE
+#define EWRAM_CODE
+#define IWRAM_DATA
+#define EWRAM_DATA
+#define EWRAM_BSS
+#define BIT(n) (1<<(n))
+#endif
@@ -0,0 +1,33 @@
+#ifndef _gba_dma_h_
+#define _gba_dma_h_
+#include "gba_types.h"
+//the address registers hold host pointers, too wide for the io copy. the
+//channels only run where a tool plays the hardware (hblank in compositor.c).
+typedef struct { uintptr_t sad; uintptr_t dad; u32 cnt; } Host_Dma;
+extern _Thread_local volatile Host_Dma host_dma[4];
+#define REG_DMA0SAD host_dma[0].sad
+#define REG_DMA0DAD host_dma[0].dad
+#define REG_DMA0CNT host_dma[0].cnt
+#define REG_DMA2SAD host_dma[2].sad
+#define REG_DMA2DAD host_dma[2].dad
+#define REG_DMA2CNT host_dma[2].cnt
+#define REG_DMA3SAD host_dma[3].sad
+#define REG_DMA3DAD host_dma[3].dad
+#define REG_DMA3CNT host_dma[3].cnt
+#define DMA_DST_INC (0<<21)
+#define DMA_DST_DEC (1<<21)
+#define DMA_DST_FIXED (2<<21)
+#define DMA_DST_RELOAD (3<<21)
+#define DMA_SRC_INC (0<<23)
+#define DMA_SRC_DEC (1<<23)
+#define DMA_SRC_FIXED (2<<23)
+#define DMA_REPEAT (1<<25)
+#define DMA16 (0<<26)
+#define DMA32 (1<<26)
+#define DMA_IMMEDIATE (0<<28)
+#define DMA_VBLANK (1<<28)
+#define DMA_HBLANK (2<<28)
+#define DMA_SPECIAL (3<<28)
+#define DMA_IRQ (1<<30)
+#define DMA_ENABLE (1<<31)
+#endif
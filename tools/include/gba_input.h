@@ -0,0 +1,9 @@
+#ifndef _gba_input_h_
+#define _gba_input_h_
+#include "gba_types.h"
+typedef enum KEYPAD_BITS { KEY_A=(1<<0), KEY_B=(1<<1), KEY_SELECT=(1<<2), KEY_START=(1<<3), KEY_RIGHT=(1<<4), KEY_LEFT=(1<<5), KEY_UP=(1<<6), KEY_DOWN=(1<<7), KEY_R=(1<<8), KEY_L=(1<<9) } KEYPAD_BITS;
+void scanKeys(void);
+u16 keysDown(void);
+u16 keysHeld(void);
+u16 keysUp(void);
+#endif
@@ -0,0 +1,13 @@
+#ifndef _gba_interrupt_h_
+#define _gba_interrupt_h_
+#include "gba_types.h"
+typedef enum irqMASKS { IRQ_VBLANK=(1<<0), IRQ_HBLANK=(1<<1), IRQ_VCOUNT=(1<<2), IRQ_TIMER0=(1<<3), IRQ_TIMER1=(1<<4), IRQ_TIMER2=(1<<5), IRQ_TIMER3=(1<<6), IRQ_SERIAL=(1<<7), IRQ_DMA0=(1<<8), IRQ_DMA1=(1<<9), IRQ_DMA2=(1<<10), IRQ_DMA3=(1<<11), IRQ_KEYPAD=(1<<12), IRQ_GAMEPAK=(1<<13) } irqMASK;
+typedef void (*IntFn)(void);
+#define REG_IE *((vu16 *)(REG_BASE + 0x200))
+#define REG_IF *((vu16 *)(REG_BASE + 0x202))
+#define REG_IME *((vu16 *)(REG_BASE + 0x208))
+void irqInit(void);
+IntFn *irqSet(irqMASK mask, IntFn function);
+void irqEnable(int mask);
+void irqDisable(int mask);
+#endif
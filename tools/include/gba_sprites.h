@@ -0,0 +1,29 @@
+#ifndef _gba_sprites_h_
+#define _gba_sprites_h_
+#include "gba_types.h"
+typedef struct { u16 attr0; u16 attr1; u16 attr2; u16 dummy; } ALIGN(4) OBJATTR;
+typedef struct { u16 dummy0[3]; s16 pa; u16 dummy1[3]; s16 pb; u16 dummy2[3]; s16 pc; u16 dummy3[3]; s16 pd; } ALIGN(4) OBJAFFINE;
+#define OAM ((OBJATTR *)host_oam)
+#define OBJ_BASE_ADR ((void *)(VRAM + 0x10000))
+#define SPRITE_GFX ((u16 *)(VRAM + 0x10000))
+#define OBJ_Y(m) ((m)&0x00ff)
+#define OBJ_ROT_SCALE_ON (1<<8)
+#define OBJ_DISABLE (1<<9)
+#define OBJ_DOUBLE (1<<9)
+#define ATTR0_ROTSCALE (1<<8)
+#define ATTR0_ROTSCALE_DOUBLE (3<<8)
+#define ATTR0_DISABLED (2<<8)
+#define ATTR0_COLOR_16 (0<<13)
+#define ATTR0_SQUARE (0<<14)
+#define OBJ_X(m) ((m)&0x01ff)
+#define ATTR1_ROTDATA(n) ((n)<<9)
+#define OBJ_ROT_SCALE(m) ((m)<<9)
+#define ATTR1_FLIP_X (1<<12)
+#define ATTR1_FLIP_Y (1<<13)
+#define ATTR1_SIZE_8 (0<<14)
+#define OBJ_CHAR(m) ((m)&0x03ff)
+#define OBJ_PRIORITY(m) ((m)<<10)
+#define ATTR2_PRIORITY(n) ((n)<<10)
+#define ATTR2_PALETTE(n) ((n)<<12)
+#define OBJ_SQUARE (0<<14)
+#endif
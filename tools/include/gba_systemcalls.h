@@ -0,0 +1,13 @@
+#ifndef _gba_systemcalls_h_
+#define _gba_systemcalls_h_
+#include "gba_types.h"
+#define COPY16 0
+#define COPY32 (1<<26)
+#define FILL (1<<24)
+void CpuSet(const void *source, void *dest, u32 mode);
+void CpuFastSet(const void *source, void *dest, u32 mode);
+void VBlankIntrWait(void);
+void IntrWait(u32 ReturnFlag, u32 flags);
+s32 Div(s32 Number, s32 Divisor);
+u16 Sqrt(u32 X);
+#endif
@@ -0,0 +1,50 @@
+#ifndef _gba_video_h_
+#define _gba_video_h_
+#include "gba_types.h"
+#define RGB8(r,g,b) ( (((b)>>3)<<10) | (((g)>>3)<<5) | ((r)>>3) )
+#define BG_PALETTE ((u16*)PALRAM)
+#define SPRITE_PALETTE ((u16*)(PALRAM+0x200))
+#define MAP_BASE_ADR(m) ((void *)(VRAM + ((m) << 11)))
+#define TILE_BASE_ADR(m) ((void *)(VRAM + ((m) << 14)))
+#define MAP_BASE(m) ((m) << 8)
+#define TILE_BASE(m) ((m) << 2)
+#define BG_16_COLOR (0<<7)
+#define BG_SIZE_0 (0<<14)
+#define BG_PRIORITY(m) ((m))
+#define REG_DISPCNT *((vu16 *)(REG_BASE + 0x00))
+#define REG_DISPSTAT *((vu16 *)(REG_BASE + 0x04))
+#define REG_VCOUNT *((vu16 *)(REG_BASE + 0x06))
+#define REG_BG0CNT *((vu16 *)(REG_BASE + 0x08))
+#define REG_BG1CNT *((vu16 *)(REG_BASE + 0x0a))
+#define REG_BG2CNT *((vu16 *)(REG_BASE + 0x0c))
+#define REG_BG3CNT *((vu16 *)(REG_BASE + 0x0e))
+#define REG_BG0HOFS *((vu16 *)(REG_BASE + 0x10))
+#define REG_BG0VOFS *((vu16 *)(REG_BASE + 0x12))
+#define REG_BG1HOFS *((vu16 *)(REG_BASE + 0x14))
+#define REG_BG1VOFS *((vu16 *)(REG_BASE + 0x16))
+#define REG_BG2HOFS *((vu16 *)(REG_BASE + 0x18))
+#define REG_BG2VOFS *((vu16 *)(REG_BASE + 0x1a))
+#define REG_BG3HOFS *((vu16 *)(REG_BASE + 0x1c))
+#define REG_BG3VOFS *((vu16 *)(REG_BASE + 0x1e))
+#define REG_WIN0H *((vu16 *)(REG_BASE + 0x40))
+#define REG_WIN1H *((vu16 *)(REG_BASE + 0x42))
+#define REG_WIN0V *((vu16 *)(REG_BASE + 0x44))
+#define REG_WIN1V *((vu16 *)(REG_BASE + 0x46))
+#define REG_WININ *((vu16 *)(REG_BASE + 0x48))
+#define REG_WINOUT *((vu16 *)(REG_BASE + 0x4a))
+#define REG_BLDCNT *((vu16 *)(REG_BASE + 0x50))
+#define REG_BLDALPHA *((vu16 *)(REG_BASE + 0x52))
+#define REG_BLDY *((vu16 *)(REG_BASE + 0x54))
+#define MODE_0 0
+#define BG0_ON (1<<8)
+#define BG1_ON (1<<9)
+#define BG2_ON (1<<10)
+#define BG3_ON (1<<11)
+#define OBJ_ON (1<<12)
+#define WIN0_ON (1<<13)
+#define WIN1_ON (1<<14)
+#define OBJ_WIN_ON (1<<15)
+#define BG_ALL_ON (BG0_ON|BG1_ON|BG2_ON|BG3_ON)
+#define OBJ_ENABLE OBJ_ON
+#define SetMode(mode) REG_DISPCNT = (mode)
+#endif
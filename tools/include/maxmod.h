@@ -0,0 +1,43 @@
+//maxmod api, every call is a no-op on the host
+#ifndef MAXMOD_H
+#define MAXMOD_H
+#include "gba_types.h"
+typedef unsigned int mm_word; typedef unsigned short mm_hword; typedef unsigned char mm_byte;
+typedef unsigned short mm_sfxhand; typedef unsigned char mm_bool; typedef void* mm_addr;
+typedef enum { MM_MIX_8KHZ, MM_MIX_10KHZ, MM_MIX_13KHZ, MM_MIX_16KHZ, MM_MIX_18KHZ, MM_MIX_21KHZ, MM_MIX_27KHZ, MM_MIX_31KHZ } mm_mixmode;
+typedef enum { MM_PLAY_LOOP, MM_PLAY_ONCE } mm_pmode;
+typedef struct { union { mm_word id; void* sample; }; mm_hword rate; mm_sfxhand handle; mm_byte volume; mm_byte panning; } mm_sound_effect;
+typedef struct { mm_mixmode mixing_mode; mm_word mod_channel_count; mm_word mix_channel_count; mm_addr module_channels; mm_addr active_channels; mm_addr mixing_channels; mm_addr mixing_memory; mm_addr wave_memory; mm_addr soundbank; } mm_gba_system;
+#define MM_SIZEOF_MODCH 40
+#define MM_SIZEOF_ACTCH 28
+#define MM_SIZEOF_MIXCH 24
+#define MM_MIXLEN_8KHZ 544
+#define MM_MIXLEN_10KHZ 704
+#define MM_MIXLEN_13KHZ 896
+#define MM_MIXLEN_16KHZ 1056
+#define MM_MIXLEN_18KHZ 1216
+#define MM_MIXLEN_21KHZ 1408
+#define MM_MIXLEN_27KHZ 1808
+#define MM_MIXLEN_31KHZ 2112
+void mmInitDefault(mm_addr soundbank, mm_word number_of_channels);
+void mmInit(mm_gba_system* setup);
+void mmVBlank(void);
+void mmFrame(void);
+void mmStart(mm_word id, mm_pmode mode);
+void mmPause(void);
+void mmResume(void);
+void mmStop(void);
+mm_bool mmActive(void);
+void mmSetModuleVolume(mm_word volume);
+void mmSetJingleVolume(mm_word volume);
+void mmSetEffectsVolume(mm_word volume);
+mm_sfxhand mmEffect(mm_word sample_ID);
+mm_sfxhand mmEffectEx(mm_sound_effect* sound);
+void mmEffectVolume(mm_sfxhand handle, mm_word volume);
+void mmEffectPanning(mm_sfxhand handle, mm_byte panning);
+void mmEffectRate(mm_sfxhand handle, mm_word rate);
+void mmEffectCancel(mm_sfxhand handle);
+void mmEffectRelease(mm_sfxhand handle);
+mm_bool mmEffectActive(mm_sfxhand handle);
+void mmEffectCancelAll(void);
+#endif
@@ -0,0 +1,3 @@
+extern const unsigned char soundbank_bin[];
+extern const unsigned char soundbank_bin_end[];
+extern const unsigned int soundbank_bin_size;
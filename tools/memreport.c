@@ -0,0 +1,78 @@
+//sizes of the object structs and where the game state's bytes go. the
+//game state holds no pointers or 64 bit fields, so the host lays it out
+//like the gba does and the numbers are the gba's. the linker prints the
+//iwram and ewram totals of a rom build.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#define main celeste_main
+#include "main.c"
+#undef main
+
+#include "host.h"
+
+#define IWRAM_SIZE 0x8000
+
+typedef struct
+{
+	const char* name;
+	u32 size;
+} Type_Size;
+
+typedef struct
+{
+	const char* name;
+	u32 offset;
+	u32 size;
+	u32 count;	//pool slots, 1 for single objects
+} Member_Size;
+
+#define TYPE(t) { #t, sizeof(t) }
+#define MEMBER(m, n) { #m, offsetof(Game, m), sizeof(((Game*)0)->m), n }
+#define ARRAY(m) MEMBER(m, sizeof(((Game*)0)->m) / sizeof(((Game*)0)->m[0]))
+
+static const Type_Size types[] = {
+	TYPE(Point), TYPE(Pointf), TYPE(Flip), TYPE(Rectangle), TYPE(Object),
+	TYPE(Balloon), TYPE(Big_Chest), TYPE(Chest), TYPE(Fall_Floor), TYPE(Flag),
+	TYPE(Fly_Fruit), TYPE(Fruit), TYPE(Lifeup), TYPE(Message), TYPE(Orb),
+	TYPE(Platform), TYPE(Player), TYPE(Player_Spawn), TYPE(Room_Title),
+	TYPE(Spring), TYPE(Landmark), TYPE(Fx)
+};
+
+static const Member_Size members[] = {
+	MEMBER(landmark, 1), MEMBER(chest, 1), MEMBER(fake_wall, 1), MEMBER(fly_fruit, 1),
+	MEMBER(fruit, 1), MEMBER(key, 1), MEMBER(lifeup, 1), MEMBER(orb, 1),
+	MEMBER(player, 1), MEMBER(player_spawn, 1), MEMBER(room_title, 1),
+	MEMBER(fx, MAX_FX+1), ARRAY(balloons), ARRAY(fall_floors), ARRAY(hair_x),
+	ARRAY(hair_y), ARRAY(platforms), ARRAY(springs)
+};
+
+
+//-- main --
+//----------
+int main(void)
+{
+	u32 counted = 0;
+
+	printf("%-14s %6s\n", "struct", "bytes");
+	for (u32 i = 0; i < sizeof(types)/sizeof(types[0]); i++)
+		printf("%-14s %6u\n", types[i].name, types[i].size);
+
+	printf("\n%-14s %6s %6s %6s %6s\n", "game state", "offset", "bytes", "slots", "each");
+	for (u32 i = 0; i < sizeof(members)/sizeof(members[0]); i++)
+	{
+		const Member_Size* m = &members[i];
+		printf("%-14s %6u %6u %6u %6u\n", m->name, m->offset, m->size, m->count, m->size / m->count);
+		counted += m->size;
+	}
+
+	//the globals follow the pools
+	u32 globals = offsetof(Game, fruits);
+	printf("%-14s %6u %6u\n", "globals", globals, (u32)sizeof(Game) - globals);
+	printf("%-14s %6s %6u\n", "padding", "", globals - counted);
+
+	printf("\ngame state %u bytes, %u.%u%% of iwram\n", (u32)sizeof(Game),
+		(u32)sizeof(Game)*100 / IWRAM_SIZE, (u32)sizeof(Game)*1000 / IWRAM_SIZE % 10);
+	return 0;
+}
@@ -0,0 +1,335 @@
+//host benchmark of the collision and movement primitives
+//each function is timed in all 32 rooms and reported as ns per call and
+//as millions of calls per second. the numbers are host numbers, use them
+//to compare builds, they say nothing about the gba's frame budget.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define main celeste_main
+#include "main.c"
+#undef main
+
+#include "host.h"
+
+#define ROOMS 32
+#define POSITIONS 256
+#define MAX_STATES 64
+#define REPEATS 5
+
+
+//-- test data --
+//---------------
+typedef struct
+{
+	u8 x, y;
+	s8 ox, oy;
+	float xspd, yspd;
+} Position;
+
+typedef struct
+{
+	Player player;
+	u16 keys;
+} State;
+
+//same positions in every room
+static Position positions[POSITIONS];
+
+//player states recorded while playing the current room
+static State states[MAX_STATES];
+static u8 state_count = 0;
+
+static u32 lcg = 1;
+static volatile u32 sink = 0;
+
+static u32 next_lcg()
+{
+	lcg = lcg*1664525 + 1013904223;
+	return lcg >> 8;
+}
+
+static void init_positions()
+{
+	lcg = 1;
+	for (u16 i = 0; i < POSITIONS; i++)
+	{
+		Position* p = &(positions[i]);
+		p->x = next_lcg() % 128;
+		p->y = next_lcg() % 128;
+		p->ox = (s8)(next_lcg() % 3) - 1;
+		p->oy = (s8)(next_lcg() % 3) - 1;
+		p->xspd = (float)((s32)(next_lcg() % 9) - 4) * 0.5f;
+		p->yspd = (float)((s32)(next_lcg() % 9) - 4) * 0.5f;
+	}
+}
+
+//play the room with random inputs and keep the player states that don't
+//leave it, so player_update() sees runs, jumps, dashes and wall slides
+static void record_states(u8 x, u8 y)
+{
+	static const u16 inputs[] = {
+		0, k_right, k_left, k_right|k_jump, k_left|k_jump, k_up|k_dash,
+		k_right|k_up|k_dash, k_left|k_up|k_dash, k_right|k_dash, k_down|k_dash
+	};
+	u16 keys = 0;
+
+	lcg = 1 + x + y*8;
+	rnd_seed = 1;
+	g->kheld = 0;
+	state_count = 0;
+	load_room(x,y);
+
+	for (u16 f = 0; f < 4000 && state_count < MAX_STATES; f++)
+	{
+		if (f % 6 == 0)
+			keys = inputs[next_lcg() % (sizeof(inputs)/sizeof(inputs[0]))];
+		g->kdown = keys & ~g->kheld;
+		g->kheld = keys;
+
+		State* s = &(states[state_count]);
+		bool record = g->player.obj.active && (f & 1);
+		if (record)
+		{
+			s->player = g->player;
+			s->keys = keys;
+		}
+
+		_update();
+
+		if (g->room.x != x || g->room.y != y)
+			load_room(x,y);
+		else if (record)
+			state_count++;
+	}
+
+	//no spawn in this room (title), stand on the first free spot
+	if (state_count == 0)
+	{
+		for (u8 i = 0; i < POSITIONS; i++)
+		{
+			if (!solid_at(positions[i].x, positions[i].y, 8, 8))
+			{
+				player_init(&g->player, positions[i].x, positions[i].y);
+				break;
+			}
+		}
+		states[0].player = g->player;
+		states[0].keys = 0;
+		state_count = 1;
+	}
+
+	g->kheld = 0;
+	g->kdown = 0;
+}
+
+
+//-- benchmarks --
+//----------------
+static void bench_tile_flag_at(u32 n)
+{
+	u32 hits = 0;
+	for (u32 i = 0; i < n; i++)
+	{
+		Position* p = &(positions[i % POSITIONS]);
+		hits += tile_flag_at(p->x, p->y, 8, 8, 0);
+	}
+	sink += hits;
+}
+
+static void bench_spikes_at(u32 n)
+{
+	u32 hits = 0;
+	for (u32 i = 0; i < n; i++)
+	{
+		Position* p = &(positions[i % POSITIONS]);
+		hits += spikes_at(p->x+1, p->y+3, 6, 5, p->xspd, p->yspd);
+	}
+	sink += hits;
+}
+
+static void bench_is_solid(u32 n)
+{
+	u32 hits = 0;
+	for (u32 i = 0; i < n; i++)
+	{
+		Position* p = &(positions[i % POSITIONS]);
+		Object* obj = &(states[i % state_count].player.obj);
+		hits += is_solid(obj, p->ox, p->oy);
+	}
+	sink += hits;
+}
+
+static void bench_collide(u32 n)
+{
+	static const u8 types[] = { type_player, type_fake_wall, type_platform, type_spring, type_fall_floor };
+	u32 hits = 0;
+	for (u32 i = 0; i < n; i++)
+	{
+		Position* p = &(positions[i % POSITIONS]);
+		Object* obj = &(states[i % state_count].player.obj);
+		hits += collide(obj, types[i % sizeof(types)], p->ox, p->oy) != NULL;
+	}
+	sink += hits;
+}
+
+static void bench_move(u32 n)
+{
+	Object obj;
+	u32 sum = 0;
+	for (u32 i = 0; i < n; i++)
+	{
+		Position* p = &(positions[i % POSITIONS]);
+		obj = states[i % state_count].player.obj;
+		move(&obj, obj.spd.x + p->xspd, obj.spd.y + p->yspd);
+		sum += (u32)obj.x + (u32)obj.y;
+	}
+	sink += sum;
+}
+
+static void bench_player_update(u32 n)
+{
+	u32 sum = 0;
+	for (u32 i = 0; i < n; i++)
+	{
+		State* s = &(states[i % state_count]);
+		g->player = s->player;
+		g->kheld = s->keys;
+		g->kdown = 0;
+		player_update(&g->player);
+		sum += (u32)g->player.obj.x + (u32)g->player.obj.y;
+	}
+	sink += sum;
+}
+
+typedef struct
+{
+	const char* name;
+	void (*run)(u32 n);
+	float ns[ROOMS];
+} Bench;
+
+static Bench benches[] = {
+	{ "tile_flag_at", bench_tile_flag_at },
+	{ "spikes_at", bench_spikes_at },
+	{ "is_solid", bench_is_solid },
+	{ "collide", bench_collide },
+	{ "move", bench_move },
+	{ "player_update", bench_player_update },
+};
+#define BENCHES (sizeof(benches)/sizeof(benches[0]))
+
+//best of REPEATS runs, in ns per call
+static float time_bench(Bench* b, u32 n)
+{
+	u64 best = ~0ull;
+
+	b->run(n/16);
+	for (u8 r = 0; r < REPEATS; r++)
+	{
+		u64 start = host_ns();
+		b->run(n);
+		u64 t = host_ns() - start;
+		if (t < best)
+			best = t;
+	}
+
+	return (float)best / n;
+}
+
+
+//-- report --
+//------------
+static void usage()
+{
+	printf("usage: physbench [-n calls] [-r] [-c]\n");
+	printf("  -n  calls per room and function (default 200000)\n");
+	printf("  -r  print every room\n");
+	printf("  -c  print csv (function,room,ns,mcalls_per_s)\n");
+}
+
+int main(int argc, char** argv)
+{
+	u32 n = 200000;
+	bool rooms = false;
+	bool csv = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-n") == 0 && i+1 < argc)
+		{
+			s32 calls = atoi(argv[++i]);
+			n = max(1, calls);
+		}
+		else if (strcmp(argv[i], "-r") == 0)
+			rooms = true;
+		else if (strcmp(argv[i], "-c") == 0)
+			csv = true;
+		else
+		{
+			usage();
+			return 1;
+		}
+	}
+
+	init_audio();
+	init_positions();
+
+	for (u8 r = 0; r < ROOMS; r++)
+	{
+		record_states(r%8, r/8);
+		for (u8 b = 0; b < BENCHES; b++)
+		{
+			//player_update() may break floors or pop balloons, start clean
+			load_room(r%8, r/8);
+			benches[b].ns[r] = time_bench(&(benches[b]), n);
+		}
+	}
+
+	if (csv)
+	{
+		printf("function,room,ns,mcalls_per_s\n");
+		for (u8 b = 0; b < BENCHES; b++)
+			for (u8 r = 0; r < ROOMS; r++)
+				printf("%s,%u,%.2f,%.0f\n", benches[b].name, r, benches[b].ns[r], 1000 / benches[b].ns[r]);
+		return 0;
+	}
+
+	if (rooms)
+	{
+		printf("%-6s", "room");
+		for (u8 b = 0; b < BENCHES; b++)
+			printf(" %14s", benches[b].name);
+		printf("\n");
+
+		for (u8 r = 0; r < ROOMS; r++)
+		{
+			printf("%-6u", r);
+			for (u8 b = 0; b < BENCHES; b++)
+				printf(" %14.2f", benches[b].ns[r]);
+			printf("\n");
+		}
+		printf("\n");
+	}
+
+	printf("%-14s %9s %9s %9s %12s\n", "function", "ns/op", "best", "worst", "Mcalls/s");
+	for (u8 b = 0; b < BENCHES; b++)
+	{
+		Bench* bench = &(benches[b]);
+		float sum = 0;
+		u8 best = 0, worst = 0;
+
+		for (u8 r = 0; r < ROOMS; r++)
+		{
+			sum += bench->ns[r];
+			if (bench->ns[r] < bench->ns[best]) best = r;
+			if (bench->ns[r] > bench->ns[worst]) worst = r;
+		}
+
+		float avg = sum / ROOMS;
+		printf("%-14s %9.2f %6.2f@%-2u %6.2f@%-2u %12.1f\n", bench->name, avg,
+			bench->ns[best], best, bench->ns[worst], worst, 1000 / avg);
+	}
+
+	return 0;
+}
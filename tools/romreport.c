@@ -0,0 +1,285 @@
+//size and speed of the build configurations (make report): rom size, iwram
+//and ewram taken by the sections in the linker map, and the cycles the
+//benchmark rom wrote to sram. the cycles come from the .sav an emulator
+//keeps next to the rom once the benchmark summary is on screen.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gba_types.h>
+
+#define IWRAM_START 0x03000000
+#define IWRAM_SIZE 0x8000
+#define EWRAM_START 0x02000000
+#define EWRAM_SIZE 0x40000
+
+#define ROOMS 32
+#define CYCLES_PER_FRAME 280896
+
+enum
+{
+	UPDATE,
+	DRAW,
+	SCREEN,
+	AUDIO,
+	SUBSYSTEMS
+};
+
+typedef struct
+{
+	const char* name;
+	s32 rom;	//-1 when there is no rom
+	s32 iwram;	//-1 when there is no map
+	s32 ewram;
+	bool timed;	//false without a .sav
+	u32 cycles[SUBSYSTEMS];	//average over the rooms
+	u32 frame;
+	u32 worst;	//room with the costliest average frame
+	u32 worst_frame;
+} Config;
+
+
+//-- inputs --
+//------------
+static s32 file_size(const char* path)
+{
+	FILE* f = fopen(path, "rb");
+	if (f == NULL)
+		return -1;
+
+	fseek(f, 0, SEEK_END);
+	s32 size = ftell(f);
+	fclose(f);
+	return size;
+}
+
+//adds up the output sections by where they live. names longer than the
+//name column get a line of their own, the address and size follow below.
+static bool map_read(const char* path, Config* config)
+{
+	FILE* f = fopen(path, "r");
+	if (f == NULL)
+		return false;
+
+	char line[512];
+	bool in_map = false;
+	bool named = false;
+	config->iwram = 0;
+	config->ewram = 0;
+
+	while (fgets(line, sizeof(line), f))
+	{
+		if (!in_map)
+		{
+			in_map = strncmp(line, "Linker script and memory map", 28) == 0;
+			continue;
+		}
+
+		char* values = NULL;
+		if (line[0] == '.')
+		{
+			values = strpbrk(line, " \t");
+			named = (values == NULL || strspn(values, " \t\r\n") == strlen(values));
+			if (named)
+				continue;
+		}
+		else if (named && (line[0] == ' ' || line[0] == '\t'))
+			values = line;
+		named = false;
+
+		unsigned long adr, size;
+		if (values == NULL || sscanf(values, " 0x%lx 0x%lx", &adr, &size) != 2)
+			continue;
+
+		if (adr >= IWRAM_START && adr < IWRAM_START+IWRAM_SIZE)
+			config->iwram += size;
+		else if (adr >= EWRAM_START && adr < EWRAM_START+EWRAM_SIZE)
+			config->ewram += size;
+	}
+
+	fclose(f);
+	return in_map;
+}
+
+//the benchmark csv at the start of sram: a header, then
+//room,update,update_max,draw,draw_max,screen,screen_max,audio,audio_max,...
+static bool sav_read(const char* path, Config* config)
+{
+	FILE* f = fopen(path, "rb");
+	if (f == NULL)
+		return false;
+
+	static char log[4096];
+	size_t len = fread(log, 1, sizeof(log)-1, f);
+	fclose(f);
+	log[len] = '\0';
+
+	if (strncmp(log, "room,update", 11) != 0)
+		return false;
+
+	u64 totals[SUBSYSTEMS] = { 0 };
+	u32 rooms = 0;
+	config->worst_frame = 0;
+
+	for (char* l = strchr(log, '\n'); l != NULL && rooms < ROOMS; l = strchr(l, '\n'))
+	{
+		char* p = ++l;
+		u32 room = strtoul(p, &p, 10);
+		u32 avg[SUBSYSTEMS];
+		u32 frame = 0;
+		bool complete = (*p == ',');
+
+		for (u8 i = 0; i < SUBSYSTEMS && complete; i++)
+		{
+			avg[i] = strtoul(p+1, &p, 10);
+			strtoul(p+1, &p, 10);	//max
+			complete = (*p == ',' || *p == '\n');
+		}
+		if (!complete)
+			break;
+
+		for (u8 i = 0; i < SUBSYSTEMS; i++)
+		{
+			totals[i] += avg[i];
+			frame += avg[i];
+		}
+
+		if (frame > config->worst_frame)
+		{
+			config->worst_frame = frame;
+			config->worst = room;
+		}
+		rooms++;
+	}
+
+	if (rooms == 0)
+		return false;
+
+	config->frame = 0;
+	for (u8 i = 0; i < SUBSYSTEMS; i++)
+	{
+		config->cycles[i] = totals[i] / rooms;
+		config->frame += config->cycles[i];
+	}
+	return true;
+}
+
+
+//-- report --
+//------------
+static void print_table(const Config* configs, u32 count)
+{
+	bool untimed = false;
+
+	printf("%-12s %8s %6s %7s %7s %7s %7s %7s %7s %6s %4s\n",
+		"config", "rom", "iwram", "ewram", "update", "draw", "screen", "audio", "frame", "/1000", "rm");
+
+	for (u32 c = 0; c < count; c++)
+	{
+		const Config* config = &configs[c];
+		printf("%-12s ", config->name);
+
+		if (config->rom < 0)
+			printf("%8s ", "-");
+		else
+			printf("%8d ", config->rom);
+
+		if (config->iwram < 0)
+			printf("%6s %7s ", "-", "-");
+		else
+			printf("%6d %7d ", config->iwram, config->ewram);
+
+		if (!config->timed)
+		{
+			printf("%7s %7s %7s %7s %7s %6s %4s\n", "-", "-", "-", "-", "-", "-", "-");
+			untimed = true;
+			continue;
+		}
+
+		for (u8 i = 0; i < SUBSYSTEMS; i++)
+			printf("%7u ", config->cycles[i]);
+		printf("%7u %6u %4u\n", config->frame, (config->frame * 1000) / (2*CYCLES_PER_FRAME), config->worst);
+	}
+
+	printf("\niwram and ewram are the static sections, out of %d and %d bytes.\n", IWRAM_SIZE, EWRAM_SIZE);
+	printf("cycles are averages per game frame over the rooms, rm is the costliest room.\n");
+	if (untimed)
+		printf("- no .sav next to the rom: run it until the benchmark summary shows, then report again.\n");
+}
+
+static void print_csv(const Config* configs, u32 count)
+{
+	printf("config,rom,iwram,ewram,update,draw,screen,audio,frame,worst_room,worst_frame\n");
+
+	for (u32 c = 0; c < count; c++)
+	{
+		const Config* config = &configs[c];
+		printf("%s,%d,%d,%d", config->name, config->rom, config->iwram, config->ewram);
+		if (config->timed)
+		{
+			for (u8 i = 0; i < SUBSYSTEMS; i++)
+				printf(",%u", config->cycles[i]);
+			printf(",%u,%u,%u\n", config->frame, config->worst, config->worst_frame);
+		}
+		else
+			printf(",,,,,,,\n");
+	}
+}
+
+
+//-- main --
+//----------
+static void usage()
+{
+	printf("usage: romreport [-c] name rom.gba rom.map [name rom.gba rom.map ...]\n");
+	printf("  -c  print csv\n");
+	printf("the cycles are read from rom.sav\n");
+}
+
+int main(int argc, char** argv)
+{
+	bool csv = false;
+	int first = 1;
+
+	if (argc > 1 && strcmp(argv[1], "-c") == 0)
+	{
+		csv = true;
+		first = 2;
+	}
+	if (argc - first < 3 || (argc - first) % 3 != 0)
+	{
+		usage();
+		return 1;
+	}
+
+	u32 count = (argc - first) / 3;
+	Config* configs = calloc(count, sizeof(Config));
+
+	for (u32 c = 0; c < count; c++)
+	{
+		Config* config = &configs[c];
+		const char* rom = argv[first + c*3 + 1];
+		const char* map = argv[first + c*3 + 2];
+
+		config->name = argv[first + c*3];
+		config->rom = file_size(rom);
+		if (!map_read(map, config))
+			config->iwram = config->ewram = -1;
+
+		//rom.gba -> rom.sav
+		char sav[1024];
+		size_t len = strlen(rom);
+		if (len > 4 && strcmp(rom + len-4, ".gba") == 0)
+			len -= 4;
+		snprintf(sav, sizeof(sav), "%.*s.sav", (int)len, rom);
+		config->timed = sav_read(sav, config);
+	}
+
+	if (csv)
+		print_csv(configs, count);
+	else
+		print_table(configs, count);
+
+	free(configs);
+	return 0;
+}
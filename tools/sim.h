@@ -0,0 +1,421 @@
+//helpers for the host tools that run the game, include after main.c. all
+//static inline, each tool only uses some of them.
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+//-- stepping --
+//--------------
+//one frame like the main loop. _draw() is part of the simulation, it uses
+//rnd() and some objects (the orb) only react to the player there.
+static inline void step(u16 keys)
+{
+	g->kdown = keys & ~g->kheld;
+	g->kheld = keys;
+
+	_update();
+	_draw();
+	if (g->freeze <= 0)
+		update_screen();
+}
+
+//dash count a normal run has in a room, the orb is in room 21
+#define ROOM_DJUMP(level) (((level) > 21)? 2: 1)
+
+//a new game and rng, as in a fresh process. the game only resets what the
+//room uses, and a dead or earlier player is still there to collide with
+static inline void fresh_game()
+{
+	*g = (Game)GAME_INIT;
+	rnd_seed = 1;
+}
+
+//start a game in a room and play until the player spawned, returns the
+//frames that took or -1 when nobody spawns
+static inline s16 enter_room(u8 level, u8 djump)
+{
+	fresh_game();
+	init_audio();
+	__init();
+	begin_game();
+	g->max_djump = djump;
+	load_room(level%8, level/8);
+
+	for (s16 f = 0; f < 120; f++)
+	{
+		if (g->player.obj.active)
+			return f;
+		step(0);
+	}
+	return -1;
+}
+
+
+//-- snapshots --
+//---------------
+//the game plus the engine state it touches, to run a game from the same
+//point many times or to move it to another thread
+typedef struct
+{
+	Game game;
+	u32 rnd_seed;
+} Snapshot;
+
+static inline void snapshot_save(Snapshot* s)
+{
+	s->game = *g;
+	s->rnd_seed = rnd_seed;
+}
+
+//the map of this thread must already hold the room (load_room())
+static inline void snapshot_load(const Snapshot* s)
+{
+	*g = s->game;
+	rnd_seed = s->rnd_seed;
+
+	//the fall floors' tiles in this thread's map
+	for (u8 i = 0; i < MAX_FALL_FLOORS; i++)
+	{
+		Fall_Floor* floor = &(g->fall_floors[i]);
+		if (floor->obj.active)
+			fall_floor_tile(floor);
+	}
+}
+
+
+//-- state keys --
+//----------------
+//the gameplay state packed into a fixed number of bits, two games that
+//play the same from here on get the same key. left out: the run clock,
+//deaths, the held keys (jumps and dashes use the player's own p_jump and
+//p_dash) and everything only drawn (particles, smoke, hair, messages,
+//player animation and landing, the screen shake). inactive objects are one
+//bit, their stale fields don't count, and neither do fields nothing reads
+//right now (the dash's target after the dash). floats keep all their bits,
+//-0 is packed as 0.
+#define STATE_KEY_WORDS 176
+
+typedef struct
+{
+	u64 words[STATE_KEY_WORDS];
+} State_Key;
+
+typedef struct
+{
+	State_Key* key;
+	u32 bit;
+} Key_Writer;
+
+static inline void pack(Key_Writer* w, u32 value, u8 bits)
+{
+	u64 v = value & (u32)((1ull << bits)-1);
+	u32 word = w->bit/64, shift = w->bit%64;
+
+	if (word >= STATE_KEY_WORDS)
+	{
+		fprintf(stderr, "state key too long\n");
+		abort();
+	}
+
+	w->key->words[word] |= v << shift;
+	if (shift+bits > 64)
+		w->key->words[word+1] |= v >> (64-shift);
+	w->bit += bits;
+}
+
+static inline void pack_float(Key_Writer* w, float f)
+{
+	u32 bits;
+	if (f == 0)
+		f = 0;
+	memcpy(&bits, &f, 4);
+	pack(w, bits, 32);
+}
+
+//false and nothing else packed when the object is gone
+static inline bool pack_object(Key_Writer* w, const Object* obj)
+{
+	pack(w, obj->active, 1);
+	if (!obj->active)
+		return false;
+
+	pack(w, obj->collideable, 1);
+	pack(w, obj->solids, 1);
+	pack(w, obj->spr, 8);
+	pack(w, obj->flip.x, 1);
+	pack(w, obj->flip.y, 1);
+	pack_float(w, obj->x);
+	pack_float(w, obj->y);
+	pack_float(w, obj->spd.x);
+	pack_float(w, obj->spd.y);
+	pack_float(w, obj->rem.x);
+	pack_float(w, obj->rem.y);
+	return true;
+}
+
+static inline void pack_player(Key_Writer* w, const Player* p)
+{
+	//the sprite only animates
+	Object obj = p->obj;
+	obj.spr = 0;
+	if (!pack_object(w, &obj))
+		return;
+
+	pack(w, p->p_jump, 1);
+	pack(w, p->p_dash, 1);
+	pack(w, p->grace, 8);
+	pack(w, p->jbuffer, 8);
+	pack(w, p->djump, 2);
+	pack(w, p->dash_time, 8);
+	if (p->dash_time > 0)
+	{
+		pack_float(w, p->dash_target.x);
+		pack_float(w, p->dash_target.y);
+		pack_float(w, p->dash_accel.x);
+		pack_float(w, p->dash_accel.y);
+	}
+
+	//only the fake wall reads it, it breaks while this runs
+	if (g->fake_wall.active)
+		pack(w, p->dash_effect_time, 8);
+}
+
+static inline void pack_player_spawn(Key_Writer* w, const Player_Spawn* s)
+{
+	pack(w, s->active, 1);
+	if (!s->active)
+		return;
+
+	pack(w, s->x, 16);
+	pack(w, s->y, 16);
+	pack(w, s->spr, 8);
+	pack(w, s->target.x, 8);
+	pack(w, s->target.y, 8);
+	pack_float(w, s->spd.x);
+	pack_float(w, s->spd.y);
+	pack(w, s->state, 8);
+	pack(w, s->delay, 8);
+	pack(w, s->solids, 1);
+	pack(w, s->flip.x, 1);
+}
+
+//the rng is rerolled by the drawn particles every frame, leave it out to
+//find the same position reached on different frames
+static inline void state_encode(State_Key* key, bool rng)
+{
+	Key_Writer w = { key, 0 };
+	memset(key, 0, sizeof(State_Key));
+
+	pack_player(&w, &g->player);
+	pack_player_spawn(&w, &g->player_spawn);
+	pack(&w, g->room_title.active, 1);
+	pack(&w, g->room_title.delay, 8);
+
+	//the room says which landmark it is, the message only draws
+	if (landmark(type_message))
+		pack(&w, 0, 1);
+	else if (pack_object(&w, &g->landmark.obj))
+	{
+		if (g->landmark.obj.type == type_big_chest)
+		{
+			pack(&w, g->landmark.big_chest.state, 8);
+			pack(&w, g->landmark.big_chest.timer, 8);
+		}
+		else
+		{
+			pack(&w, g->landmark.flag.score, 8);
+			pack(&w, g->landmark.flag.show, 1);
+		}
+	}
+	if (pack_object(&w, &g->chest.obj))
+	{
+		pack(&w, g->chest.start, 8);
+		pack(&w, g->chest.timer, 8);
+	}
+	pack_object(&w, &g->fake_wall);
+	if (pack_object(&w, &g->fly_fruit.obj))
+	{
+		pack(&w, g->fly_fruit.start, 8);
+		pack(&w, g->fly_fruit.fly, 1);
+		pack_float(&w, g->fly_fruit.step);
+		pack(&w, g->fly_fruit.sfx_delay, 8);
+	}
+	if (pack_object(&w, &g->fruit.obj))
+	{
+		pack(&w, g->fruit.start, 8);
+		pack(&w, g->fruit.off, 8);
+	}
+	pack_object(&w, &g->key);
+	pack_object(&w, &g->orb.obj);
+
+	for (u8 i = 0; i < MAX_BALLOONS; i++)
+	{
+		Balloon* b = &(g->balloons[i]);
+		if (pack_object(&w, &b->obj))
+		{
+			pack_float(&w, b->offset);
+			pack_float(&w, b->start);
+			pack(&w, b->timer, 8);
+		}
+	}
+	for (u8 i = 0; i < MAX_FALL_FLOORS; i++)
+	{
+		Fall_Floor* f = &(g->fall_floors[i]);
+		if (pack_object(&w, &f->obj))
+		{
+			pack(&w, f->state, 8);
+			pack(&w, f->solid, 1);
+			pack(&w, f->delay, 8);
+		}
+	}
+	for (u8 i = 0; i < MAX_PLATFORMS; i++)
+	{
+		Platform* p = &(g->platforms[i]);
+		if (pack_object(&w, &p->obj))
+			pack_float(&w, p->last);
+	}
+	for (u8 i = 0; i < MAX_SPRINGS; i++)
+	{
+		Spring* s = &(g->springs[i]);
+		if (pack_object(&w, &s->obj))
+		{
+			pack(&w, s->hide_in, 8);
+			pack(&w, s->hide_for, 8);
+			pack(&w, s->delay, 8);
+		}
+	}
+
+	pack(&w, g->room.x, 3);
+	pack(&w, g->room.y, 3);
+	pack(&w, g->freeze, 8);
+	pack(&w, g->will_restart, 1);
+	pack(&w, g->delay_restart, 8);
+	pack(&w, g->fruits, 32);
+	pack(&w, g->has_dashed, 1);
+	pack(&w, g->has_key, 1);
+	pack(&w, g->pause_player, 1);
+	pack(&w, g->flash_bg, 1);
+	pack(&w, g->max_djump, 2);
+	pack(&w, g->new_bg, 1);
+	pack(&w, g->start_game, 1);
+	pack(&w, g->start_game_flash, 16);
+
+	if (rng)
+		pack(&w, rnd_seed, 32);
+}
+
+static inline bool state_equal(const State_Key* a, const State_Key* b)
+{
+	return memcmp(a, b, sizeof(State_Key)) == 0;
+}
+
+//64 bit multiply and xorshift over the words, never 0 so it can mark
+//empty slots of a hash table
+static inline u64 state_hash(const State_Key* key)
+{
+	u64 h = 0x9e3779b97f4a7c15ull;
+	for (u32 i = 0; i < STATE_KEY_WORDS; i++)
+	{
+		h ^= key->words[i];
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 32;
+	}
+	h ^= h >> 29;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 32;
+	return h? h: 1;
+}
+
+//-- replays --
+//-------------
+//a header, then the held keys of every frame starting at load_room()
+#define REPLAY_MAGIC 0x4C505243	//"CRPL"
+#define REPLAY_VERSION 1
+
+typedef struct
+{
+	u32 magic;
+	u8 version;
+	u8 level;
+	u8 djump;
+	u8 pad;
+	u32 frames;
+} Replay_Header;
+
+typedef struct
+{
+	u8 level;
+	u8 djump;
+	u32 frames;
+	u16* keys;
+} Replay;
+
+static inline bool replay_write(const char* path, const Replay* replay)
+{
+	Replay_Header header = { REPLAY_MAGIC, REPLAY_VERSION, replay->level, replay->djump, 0, replay->frames };
+	FILE* f = fopen(path, "wb");
+	if (f == NULL)
+		return false;
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+		fwrite(replay->keys, sizeof(u16), replay->frames, f) == replay->frames;
+	return (fclose(f) == 0) && ok;
+}
+
+//keys are malloc'd, free them when done
+static inline bool replay_read(const char* path, Replay* replay)
+{
+	Replay_Header header;
+	FILE* f = fopen(path, "rb");
+	if (f == NULL)
+		return false;
+
+	if (fread(&header, sizeof(header), 1, f) != 1 ||
+		header.magic != REPLAY_MAGIC || header.version != REPLAY_VERSION || header.level >= 30)
+	{
+		fclose(f);
+		return false;
+	}
+
+	replay->level = header.level;
+	replay->djump = header.djump;
+	replay->frames = header.frames;
+	replay->keys = malloc(header.frames * sizeof(u16) + 1);
+
+	bool ok = fread(replay->keys, sizeof(u16), header.frames, f) == header.frames;
+	fclose(f);
+	if (!ok)
+		free(replay->keys);
+	return ok;
+}
+
+//a fresh game in the replay's room, ready for its first keys
+static inline void replay_begin(const Replay* replay)
+{
+	fresh_game();
+	init_audio();
+	__init();
+	begin_game();
+	g->max_djump = replay->djump;
+	load_room(replay->level%8, replay->level/8);
+}
+
+//"R.J." style name of held keys for printing
+static inline const char* keys_name(u16 keys)
+{
+	static THREAD_LOCAL char str[7];
+	str[0] = (keys & k_left)? 'L': '.';
+	str[1] = (keys & k_right)? 'R': '.';
+	str[2] = (keys & k_up)? 'U': '.';
+	str[3] = (keys & k_down)? 'D': '.';
+	str[4] = (keys & k_jump)? 'J': '.';
+	str[5] = (keys & k_dash)? 'X': '.';
+	str[6] = '\0';
+	return str;
+}
+
+#endif
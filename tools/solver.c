@@ -0,0 +1,784 @@
+//finds the fewest frames out of a room with the real player physics, frame
+//by frame: every state is stepped with every input and states reached
+//before are dropped (by their whole state key, sim.h). first a beam search
+//that keeps a few states per pixel and the ones closest to the exit finds a
+//way out. then an exact search looks for a shorter one and drops every
+//state that couldn't leave the room in time even at top speed. when it runs
+//out of states the result is the optimum, when a frame holds more than -m
+//states it stops with a lower bound. the inputs are written as a replay.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define main celeste_main
+#include "main.c"
+#undef main
+
+#include "host.h"
+#include "sim.h"
+
+#define INPUTS 24
+#define CHUNK 32
+
+
+//-- options --
+//-------------
+static u8 level = 0;
+static u8 djump = 0;
+static u32 threads = 0;
+static u32 beam = 20000;
+static u32 per_pixel = 8;
+static u32 max_states = 250000;	//per frame of the exact search, 0 skips it
+static u32 max_frames = 600;
+static const char* out_path = NULL;
+
+
+//-- search state --
+//------------------
+typedef struct
+{
+	u64 hash;
+	u32 at;	//key words in the thread's list
+	u8 words;
+	u8 thread;
+	u8 input;
+	u8 djump;
+	u16 left;	//fewest frames to the exit from here
+	float y;	//distance to the exit, rooms are left at the top
+	u32 pixel;	//position on screen
+	float speed;	//upwards and sideways
+	u32 parent;
+} Candidate;
+
+typedef struct
+{
+	u32 parent;
+	u8 input;
+} Link;
+
+typedef struct
+{
+	Candidate* list;
+	u32 count;
+	u32 size;
+	u64* words;	//the keys of the list
+	u32 word_count;
+	u32 word_size;
+	u64 solution;	//parent*INPUTS + input, ~0 if none
+} Thread_Out;
+
+enum { FOUND, NOT_FOUND, TOO_MANY };
+
+static u16 inputs[INPUTS];
+static Snapshot start;
+static s16 spawn;
+
+//the search running, a beam of this many states or 0 for the exact one that
+//only keeps states that can still leave the room before bound frames
+static u32 width;
+static u32 bound;
+
+static Snapshot* nodes;
+static Snapshot* next_nodes;
+static u32 node_count;
+
+static Candidate* kept;
+static u32 kept_count;
+
+static Link** links;	//per frame, how each node was reached
+
+static Thread_Out* outs;
+static atomic_uint next_chunk;
+
+//visited states of every frame, a hash table over the keys. the exact
+//search keeps the keys up to their last used word (the rest of a key is 0)
+//to tell states apart for sure. the beam search is only an upper bound and
+//marks every state it saw by the hash alone
+#define HASH_ONLY ~0ull
+
+typedef struct
+{
+	u64 hash;	//0 for an empty slot
+	u64 at;	//the word count, then the words, in visited_words
+} Visit;
+
+static Visit* visited;
+static u64 visited_size;
+static u64 visited_count;
+static u64* visited_words;
+static u64 visited_word_count;
+static u64 visited_word_size;
+
+
+//-- visited states --
+//--------------------
+static u8 key_length(const State_Key* key)
+{
+	u8 n = STATE_KEY_WORDS;
+	while (n > 0 && key->words[n-1] == 0)
+		n--;
+	return n;
+}
+
+static const u64* candidate_key(const Candidate* c)
+{
+	return &outs[c->thread].words[c->at];
+}
+
+//the slot of the key, or the empty slot it goes in. equal up to the last
+//used word is state_equal() on the whole keys
+static u64 find(u64 hash, const u64* words, u8 n)
+{
+	for (u64 i = hash & (visited_size-1); ; i = (i+1) & (visited_size-1))
+	{
+		const Visit* v = &visited[i];
+		if (v->hash == 0)
+			return i;
+		if (v->hash == hash && (v->at == HASH_ONLY || (visited_words[v->at] == n &&
+			memcmp(&visited_words[v->at+1], words, n * sizeof(u64)) == 0)))
+			return i;
+	}
+}
+
+static bool seen(u64 hash, const u64* words, u8 n)
+{
+	return visited_size > 0 && visited[find(hash, words, n)].hash != 0;
+}
+
+//words NULL to mark it by the hash alone
+static void visit(u64 hash, const u64* words, u8 n)
+{
+	if (visited_count*2 >= visited_size)
+	{
+		Visit* old = visited;
+		u64 old_size = visited_size;
+
+		visited_size = max(1<<16, visited_size*2);
+		visited = calloc(visited_size, sizeof(Visit));
+		for (u64 i = 0; i < old_size; i++)
+		{
+			if (old[i].hash == 0)
+				continue;
+			u64 j = old[i].hash & (visited_size-1);
+			while (visited[j].hash != 0)
+				j = (j+1) & (visited_size-1);
+			visited[j] = old[i];
+		}
+		free(old);
+	}
+
+	u64 slot = find(hash, words, n);
+	if (visited[slot].hash != 0)
+		return;
+
+	visited_count++;
+	visited[slot].hash = hash;
+	if (words == NULL)
+	{
+		visited[slot].at = HASH_ONLY;
+		return;
+	}
+
+	if (visited_word_count + n+1 > visited_word_size)
+	{
+		visited_word_size = max(1<<20, visited_word_size*2);
+		visited_words = realloc(visited_words, visited_word_size * sizeof(u64));
+	}
+	visited[slot].at = visited_word_count;
+	visited_words[visited_word_count++] = n;
+	memcpy(&visited_words[visited_word_count], words, n * sizeof(u64));
+	visited_word_count += n;
+}
+
+static void forget_visited()
+{
+	free(visited);
+	free(visited_words);
+	visited = NULL;
+	visited_words = NULL;
+	visited_size = visited_count = 0;
+	visited_word_size = visited_word_count = 0;
+}
+
+
+//-- distance to the exit --
+//--------------------------
+//fewest frames from each player position to above the room (y < -4) at
+//top speed. a frame moves the player at most 7 pixels sideways (a move
+//steps one pixel further than a dash's speed of 5, and 1 more on a
+//platform) and 6 up or down, 8 more where a spring sets them on top of it.
+//only the tiles block, fall floors count as broken and the screen's edges
+//as open (the player is moved back onto them, walls or not), so this is
+//never more than the real number of frames
+#define AREA_X -8
+#define AREA_Y -8
+#define AREA_W 144
+#define AREA_H 144
+#define FAR 0xffff
+
+static u16 frames_left[AREA_H][AREA_W];
+
+static u16 exit_frames(float x, float y)
+{
+	s32 ax = flr(x) - AREA_X;
+	s32 ay = flr(y) - AREA_Y;
+	if (ax < 0 || ay < 0 || ax >= AREA_W || ay >= AREA_H || frames_left[ay][ax] == FAR)
+		return 0;
+	return frames_left[ay][ax];
+}
+
+static void exit_distances()
+{
+	static bool open[AREA_H][AREA_W];
+	static u16 queue[AREA_H*AREA_W];
+	const Object* p = &(g->player.obj);
+	u8 reach_y = 6;
+	u32 first = 0, last = 0;
+
+	for (u8 i = 0; i < MAX_FALL_FLOORS; i++)
+		if (g->fall_floors[i].obj.active)
+			fall_floor_set(&(g->fall_floors[i]), 0);
+	for (u8 i = 0; i < MAX_SPRINGS; i++)
+		if (g->springs[i].obj.active)
+			reach_y = 6+8;
+
+	for (s32 y = 0; y < AREA_H; y++)
+	{
+		for (s32 x = 0; x < AREA_W; x++)
+		{
+			//the same wrapping to u8 as is_solid()
+			open[y][x] = !solid_at((u8)(x+AREA_X+p->hitbox.x), (u8)(y+AREA_Y+p->hitbox.y), p->hitbox.w, p->hitbox.h) ||
+				x+AREA_X <= -1 || x+AREA_X >= 121;
+			frames_left[y][x] = FAR;
+			if (open[y][x] && y+AREA_Y < -4)
+			{
+				frames_left[y][x] = 0;
+				queue[last++] = y*AREA_W + x;
+			}
+		}
+	}
+
+	while (first < last)
+	{
+		s32 x = queue[first] % AREA_W;
+		s32 y = queue[first] / AREA_W;
+		first++;
+
+		for (s32 ny = max(0, y-reach_y); ny <= min(AREA_H-1, y+reach_y); ny++)
+		{
+			for (s32 nx = max(0, x-7); nx <= min(AREA_W-1, x+7); nx++)
+			{
+				if (!open[ny][nx] || frames_left[ny][nx] != FAR)
+					continue;
+				frames_left[ny][nx] = frames_left[y][x] + 1;
+				queue[last++] = ny*AREA_W + nx;
+			}
+		}
+	}
+
+	for (u8 i = 0; i < MAX_FALL_FLOORS; i++)
+		if (g->fall_floors[i].obj.active)
+			fall_floor_tile(&(g->fall_floors[i]));
+}
+
+
+//-- worker threads --
+//--------------------
+enum { PHASE_EXPAND, PHASE_MATERIALIZE, PHASE_QUIT };
+
+static pthread_barrier_t start_barrier, done_barrier;
+static u8 phase;
+
+static void push(Thread_Out* out, Candidate* c, const State_Key* key)
+{
+	if (out->count == out->size)
+	{
+		out->size = max(1024, out->size*2);
+		out->list = realloc(out->list, out->size * sizeof(Candidate));
+	}
+	if (out->word_count + c->words > out->word_size)
+	{
+		out->word_size = max(1<<16, out->word_size*2);
+		out->words = realloc(out->words, out->word_size * sizeof(u64));
+	}
+
+	c->thread = out - outs;
+	c->at = out->word_count;
+	memcpy(&out->words[out->word_count], key->words, c->words * sizeof(u64));
+	out->word_count += c->words;
+	out->list[out->count++] = *c;
+}
+
+static void expand(Thread_Out* out, u32 first, u32 last)
+{
+	Point room = g->room;
+
+	for (u32 i = first; i < last; i++)
+	{
+		for (u8 k = 0; k < INPUTS; k++)
+		{
+			snapshot_load(&nodes[i]);
+			step(inputs[k]);
+
+			if (g->room.x != room.x || g->room.y != room.y)
+			{
+				u64 solution = (u64)i*INPUTS + k;
+				if (solution < out->solution)
+					out->solution = solution;
+				load_room(room.x, room.y);
+				continue;
+			}
+
+			if (!g->player.obj.active || g->will_restart)
+				continue;
+
+			//without the rng, the particles reroll it every frame
+			State_Key key;
+			state_encode(&key, false);
+
+			s16 x = flr(g->player.obj.x);
+			s16 y = flr(g->player.obj.y);
+			Candidate c = { state_hash(&key), 0, key_length(&key), 0, k, g->player.djump,
+				exit_frames(g->player.obj.x, g->player.obj.y), g->player.obj.y,
+				(u16)(y+64)*256 + (u16)(x+64), abs(g->player.obj.spd.x) - g->player.obj.spd.y, i };
+			push(out, &c, &key);
+		}
+	}
+}
+
+static void materialize(u32 first, u32 last)
+{
+	for (u32 i = first; i < last; i++)
+	{
+		snapshot_load(&nodes[kept[i].parent]);
+		step(inputs[kept[i].input]);
+		snapshot_save(&next_nodes[i]);
+	}
+}
+
+static void* worker(void* arg)
+{
+	Thread_Out* out = arg;
+	g = malloc(sizeof(Game));
+
+	//the map of this thread
+	enter_room(level, djump);
+
+	while (1)
+	{
+		pthread_barrier_wait(&start_barrier);
+		if (phase == PHASE_QUIT)
+			break;
+
+		u32 count = (phase == PHASE_EXPAND)? node_count: kept_count;
+		while (1)
+		{
+			u32 first = atomic_fetch_add(&next_chunk, CHUNK);
+			if (first >= count)
+				break;
+
+			u32 last = min(first+CHUNK, count);
+			if (phase == PHASE_EXPAND)
+				expand(out, first, last);
+			else
+				materialize(first, last);
+		}
+
+		pthread_barrier_wait(&done_barrier);
+	}
+
+	free(g);
+	return NULL;
+}
+
+static void run_phase(u8 p)
+{
+	phase = p;
+	atomic_store(&next_chunk, 0);
+	pthread_barrier_wait(&start_barrier);
+	if (p != PHASE_QUIT)
+		pthread_barrier_wait(&done_barrier);
+}
+
+
+//-- search --
+//------------
+static int by_key(const void* a, const void* b)
+{
+	const Candidate* x = a;
+	const Candidate* y = b;
+	if (x->hash != y->hash) return (x->hash < y->hash)? -1: 1;
+	if (x->words != y->words) return x->words - y->words;
+	int keys = memcmp(candidate_key(x), candidate_key(y), x->words * sizeof(u64));
+	if (keys != 0) return keys;
+	if (x->parent != y->parent) return (x->parent < y->parent)? -1: 1;
+	return x->input - y->input;
+}
+
+static int by_pixel(const void* a, const void* b)
+{
+	const Candidate* x = a;
+	const Candidate* y = b;
+	if (x->pixel != y->pixel) return (x->pixel < y->pixel)? -1: 1;
+	if (x->djump != y->djump) return y->djump - x->djump;
+	if (x->speed != y->speed) return (x->speed > y->speed)? -1: 1;
+	if (x->parent != y->parent) return (x->parent < y->parent)? -1: 1;
+	return x->input - y->input;
+}
+
+static int by_distance(const void* a, const void* b)
+{
+	const Candidate* x = a;
+	const Candidate* y = b;
+	if (x->y != y->y) return (x->y < y->y)? -1: 1;
+	if (x->djump != y->djump) return y->djump - x->djump;
+	if (x->parent != y->parent) return (x->parent < y->parent)? -1: 1;
+	return x->input - y->input;
+}
+
+static bool same_state(const Candidate* x, const Candidate* y)
+{
+	return x->hash == y->hash && x->words == y->words &&
+		memcmp(candidate_key(x), candidate_key(y), x->words * sizeof(u64)) == 0;
+}
+
+//new states of this frame, depth frames in, the ones not reached before.
+//the exact search keeps the ones that can still leave the room before the
+//bound. the beam search keeps a few per pixel so the whole room stays
+//covered, then the ones closest to the exit first
+static void select_states(u32 depth)
+{
+	u32 total = 0;
+	for (u32 t = 0; t < threads; t++)
+		total += outs[t].count;
+
+	kept = realloc(kept, max(1, total) * sizeof(Candidate));
+	kept_count = 0;
+	for (u32 t = 0; t < threads; t++)
+	{
+		memcpy(&kept[kept_count], outs[t].list, outs[t].count * sizeof(Candidate));
+		kept_count += outs[t].count;
+		outs[t].count = 0;
+	}
+
+	//same order whatever thread found them
+	qsort(kept, kept_count, sizeof(Candidate), by_key);
+
+	u32 n = 0;
+	for (u32 i = 0; i < kept_count; i++)
+	{
+		Candidate c = kept[i];
+		if (i > 0 && same_state(&c, &kept[i-1]))
+			continue;
+		if (seen(c.hash, candidate_key(&c), c.words))
+			continue;
+		if (bound > 0 && depth + max(1, c.left) >= bound)
+			continue;
+		kept[n++] = c;
+		if (width > 0)
+			visit(c.hash, NULL, 0);
+	}
+
+	if (width > 0)
+	{
+		//states on the same pixel differ by subpixels and speed, the ones
+		//with dashes left and then the fastest come first
+		qsort(kept, n, sizeof(Candidate), by_pixel);
+
+		u32 m = 0;
+		u32 same = 0;
+		for (u32 i = 0; i < n; i++)
+		{
+			same = (i > 0 && kept[i].pixel == kept[i-1].pixel)? same+1: 0;
+			if (same < per_pixel)
+				kept[m++] = kept[i];
+		}
+
+		qsort(kept, m, sizeof(Candidate), by_distance);
+		n = min(m, width);
+	}
+
+	kept_count = n;
+	if (width == 0)
+	{
+		for (u32 i = 0; i < kept_count; i++)
+			visit(kept[i].hash, candidate_key(&kept[i]), kept[i].words);
+	}
+}
+
+static void input_set()
+{
+	static const u16 horizontal[3] = { 0, k_left, k_right };
+	static const u16 vertical[4] = { 0, 0, k_up, k_down };
+	u8 n = 0;
+
+	//up and down only matter for the dash direction
+	for (u8 h = 0; h < 3; h++)
+		for (u8 j = 0; j < 2; j++)
+			for (u8 v = 0; v < 4; v++)
+				inputs[n++] = horizontal[h] | (j? k_jump: 0) | ((v > 0)? k_dash | vertical[v]: 0);
+}
+
+static void usage()
+{
+	printf("usage: solver [-r room] [-d djump] [-t threads] [-b beam] [-p states] [-m states] [-f frames] [-o replay]\n");
+	printf("  -r  room to solve, 0-29 (default 0)\n");
+	printf("  -d  dashes (default what a normal run has)\n");
+	printf("  -t  threads (default one per core)\n");
+	printf("  -b  states per frame of the beam search that finds a first way out (default 20000)\n");
+	printf("  -p  most states kept per pixel by the beam search (default 8)\n");
+	printf("  -m  most states of a frame before the exact search stops with a lower bound\n");
+	printf("      (default 250000, 0 skips it and the result is an upper bound)\n");
+	printf("  -f  give up after this many frames (default 600)\n");
+	printf("  -o  replay file (default room<n>.rpl)\n");
+}
+
+//one search from the room's start. the way out goes to replay, the fewest
+//frames still possible to lower when a frame had too many states
+static u8 search(Replay* replay, u32* lower)
+{
+	u64 begin = host_ns();
+	u64 expanded = 0;
+	u64 solution = ~0ull;
+	u8 outcome = NOT_FOUND;
+	u32 frame;
+
+	forget_visited();
+	nodes = realloc(nodes, sizeof(Snapshot));
+	nodes[0] = start;
+	node_count = 1;
+
+	snapshot_load(&start);
+	State_Key key;
+	state_encode(&key, false);
+	visit(state_hash(&key), key.words, key_length(&key));
+
+	for (frame = 0; frame < max_frames && node_count > 0; frame++)
+	{
+		for (u32 t = 0; t < threads; t++)
+		{
+			outs[t].solution = ~0ull;
+			outs[t].count = 0;
+			outs[t].word_count = 0;
+		}
+
+		run_phase(PHASE_EXPAND);
+		expanded += (u64)node_count * INPUTS;
+
+		for (u32 t = 0; t < threads; t++)
+			solution = min(solution, outs[t].solution);
+		if (solution != ~0ull)
+		{
+			outcome = FOUND;
+			break;
+		}
+
+		select_states(frame+1);
+		if (width == 0 && kept_count > max_states)
+		{
+			printf("%u states on frame %u, more than -m allows\n", kept_count, frame+1);
+			*lower = bound;
+			for (u32 i = 0; i < kept_count; i++)
+				*lower = min(*lower, frame+1 + max(1, kept[i].left));
+			outcome = TOO_MANY;
+			break;
+		}
+
+		links[frame] = malloc(max(1, kept_count) * sizeof(Link));
+		for (u32 i = 0; i < kept_count; i++)
+		{
+			links[frame][i].parent = kept[i].parent;
+			links[frame][i].input = kept[i].input;
+		}
+
+		next_nodes = realloc(next_nodes, max(1, kept_count) * sizeof(Snapshot));
+		run_phase(PHASE_MATERIALIZE);
+
+		Snapshot* swap = nodes;
+		nodes = next_nodes;
+		next_nodes = swap;
+		node_count = kept_count;
+
+		if (frame % 10 == 9)
+			printf("frame %u: %u states, %llu visited\n", frame+1, node_count, (unsigned long long)visited_count);
+	}
+
+	double secs = (host_ns() - begin) / 1e9;
+	printf("%llu states stepped in %.2fs (%.0f/s)\n", (unsigned long long)expanded, secs, expanded / secs);
+
+	//walk back from the last frame
+	if (outcome == FOUND)
+	{
+		u32 node = solution / INPUTS;
+		replay->level = level;
+		replay->djump = djump;
+		replay->frames = spawn + frame+1;
+		replay->keys = calloc(replay->frames, sizeof(u16));
+
+		replay->keys[spawn + frame] = inputs[solution % INPUTS];
+		for (s32 f = frame-1; f >= 0; f--)
+		{
+			replay->keys[spawn + f] = inputs[links[f][node].input];
+			node = links[f][node].parent;
+		}
+	}
+
+	for (u32 f = 0; f < frame; f++)
+	{
+		free(links[f]);
+		links[f] = NULL;
+	}
+	return outcome;
+}
+
+int main(int argc, char** argv)
+{
+	char default_path[32];
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (i+1 >= argc || argv[i][0] != '-')
+		{
+			usage();
+			return 1;
+		}
+
+		const char* arg = argv[++i];
+		u32 value = strtoul(arg, NULL, 0);
+		switch (argv[i-1][1])
+		{
+			case 'r': level = min(29, value); break;
+			case 'd': djump = min(2, value); break;
+			case 't': threads = value; break;
+			case 'b': beam = max(1, value); break;
+			case 'p': per_pixel = max(1, value); break;
+			case 'm': max_states = value; break;
+			case 'f': max_frames = max(1, value); break;
+			case 'o': out_path = arg; break;
+			default:
+				usage();
+				return 1;
+		}
+	}
+
+	if (djump == 0)
+		djump = ROOM_DJUMP(level);
+	if (threads == 0)
+		threads = max(1, sysconf(_SC_NPROCESSORS_ONLN));
+	if (out_path == NULL)
+	{
+		snprintf(default_path, sizeof(default_path), "room%u.rpl", level);
+		out_path = default_path;
+	}
+
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	input_set();
+
+	spawn = enter_room(level, djump);
+	if (spawn < 0)
+	{
+		printf("no player in room %u\n", level);
+		return 1;
+	}
+	snapshot_save(&start);
+	exit_distances();
+	printf("room %u, %u dashes, %u threads, at least %u frames at top speed\n",
+		level, djump, threads, max(1, exit_frames(g->player.obj.x, g->player.obj.y)));
+
+	outs = calloc(threads, sizeof(Thread_Out));
+	links = calloc(max_frames, sizeof(Link*));
+
+	pthread_t* pool = malloc(threads * sizeof(pthread_t));
+	pthread_barrier_init(&start_barrier, NULL, threads+1);
+	pthread_barrier_init(&done_barrier, NULL, threads+1);
+	for (u32 t = 0; t < threads; t++)
+		pthread_create(&pool[t], NULL, worker, &outs[t]);
+
+	Replay replay = { 0 };
+	u32 lower = 0;
+
+	printf("beam search, %u states a frame\n", beam);
+	width = beam;
+	bound = 0;
+	bool found = (search(&replay, &lower) == FOUND);
+	u32 frames = found? replay.frames - spawn: 0;
+	if (found)
+		printf("a way out in %u frames\n", frames);
+
+	//anything shorter, or anything at all when the beam found nothing
+	u8 outcome = NOT_FOUND;
+	if (max_states > 0)
+	{
+		Replay shorter;
+		width = 0;
+		bound = found? frames: max_frames+1;
+		printf("exact search, under %u frames\n", bound);
+
+		outcome = search(&shorter, &lower);
+		if (outcome == FOUND)
+		{
+			free(replay.keys);
+			replay = shorter;
+			found = true;
+			frames = replay.frames - spawn;
+			lower = frames;
+		}
+		else if (outcome == NOT_FOUND)
+			lower = bound;
+	}
+
+	run_phase(PHASE_QUIT);
+	for (u32 t = 0; t < threads; t++)
+		pthread_join(pool[t], NULL);
+
+	if (!found)
+	{
+		if (max_states == 0)
+			printf("no way out found in %u frames\n", max_frames);
+		else if (outcome == NOT_FOUND)
+			printf("no way out in %u frames\n", max_frames);
+		else
+			printf("no way out found, it takes at least %u frames\n", lower);
+		return 1;
+	}
+
+	//play it back from the start to be sure
+	enter_room(level, djump);
+	for (u32 f = spawn; f < replay.frames; f++)
+		step(replay.keys[f]);
+	bool verified = (g->room.x != level%8 || g->room.y != level/8);
+
+	char bound_str[48];
+	if (lower >= frames)
+		snprintf(bound_str, sizeof(bound_str), ", optimal");
+	else if (max_states == 0)
+		snprintf(bound_str, sizeof(bound_str), ", an upper bound");
+	else
+		snprintf(bound_str, sizeof(bound_str), ", the optimum is %u or more", lower);
+
+	printf("%s: %u frames after spawning (%.2fs)%s%s\n", verified? "solved": "replay does not leave the room",
+		frames, frames / 30.0f, bound_str, verified? "": "!");
+
+	u16 run = 0;
+	for (u32 f = spawn; f < replay.frames; f++)
+	{
+		run++;
+		if (f+1 == replay.frames || replay.keys[f+1] != replay.keys[f])
+		{
+			printf("  %s x%u\n", keys_name(replay.keys[f]), run);
+			run = 0;
+		}
+	}
+
+	if (!replay_write(out_path, &replay))
+	{
+		printf("could not write %s\n", out_path);
+		return 1;
+	}
+	printf("replay written to %s\n", out_path);
+
+	return verified? 0: 1;
+}
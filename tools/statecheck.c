@@ -0,0 +1,218 @@
+//checks the state keys of sim.h (make check): a quick save and load gives
+//back the same key, -0 and 0 speeds are one key, the stale fields of
+//inactive slots, fields nothing reads (the dash's target after the dash,
+//the screen shake) and, unless asked for, the rng don't change the key.
+//every room is played for a while with random inputs first.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define main celeste_main
+#include "main.c"
+#undef main
+
+#include "host.h"
+#include "sim.h"
+
+#define ROOMS 30
+#define FRAMES 200
+
+static u32 lcg = 1;
+static u32 failures = 0;
+
+
+//-- helpers --
+//-------------
+static u32 next_lcg()
+{
+	lcg = lcg*1664525 + 1013904223;
+	return lcg >> 8;
+}
+
+//somewhere in the room: random runs, jumps and dashes
+static void play_room(u8 level)
+{
+	static const u16 inputs[] = {
+		0, k_right, k_left, k_right|k_jump, k_left|k_jump, k_up|k_dash,
+		k_right|k_up|k_dash, k_left|k_up|k_dash, k_right|k_dash, k_down|k_dash
+	};
+	u16 keys = 0;
+
+	lcg = 1 + level;
+	enter_room(level, ROOM_DJUMP(level));
+	for (u16 f = 0; f < FRAMES; f++)
+	{
+		if (f % 6 == 0)
+			keys = inputs[next_lcg() % (sizeof(inputs)/sizeof(inputs[0]))];
+		step(keys);
+	}
+}
+
+static bool same_key(const State_Key* a, bool rng)
+{
+	State_Key b;
+	state_encode(&b, rng);
+	return state_equal(a, &b);
+}
+
+static void expect(bool ok, const char* check, u8 level)
+{
+	if (ok)
+		return;
+	printf("room %u: %s\n", level, check);
+	failures++;
+}
+
+//garbage in every field of an inactive slot
+#define STALE(p) \
+	if (!(p)->obj.active) \
+	{ \
+		memset((p), 0xa5, sizeof(*(p))); \
+		(p)->obj.active = false; \
+	}
+
+
+//-- checks --
+//------------
+static void check_save_load(u8 level)
+{
+	State_Key key;
+	state_encode(&key, true);
+	save_state();
+
+	for (u16 f = 0; f < 30; f++)
+		step(k_right|k_jump);
+
+	expect(load_state(), "quick load failed", level);
+	expect(same_key(&key, true), "quick save and load changed the key", level);
+}
+
+static void check_negative_zero(u8 level)
+{
+	Player saved = g->player;
+	State_Key key;
+
+	g->player.obj.active = true;
+	g->player.obj.spd.x = 0.0f;
+	g->player.obj.spd.y = 0.0f;
+	g->player.obj.rem.x = 0.0f;
+	state_encode(&key, false);
+
+	g->player.obj.spd.x = -0.0f;
+	g->player.obj.spd.y = -0.0f;
+	g->player.obj.rem.x = -0.0f;
+	expect(same_key(&key, false), "-0 and 0 speeds give different keys", level);
+
+	//and the key does see the player
+	g->player.obj.spd.x = 1.0f;
+	expect(!same_key(&key, false), "a different speed gives the same key", level);
+
+	g->player = saved;
+}
+
+static void check_stale_slots(u8 level)
+{
+	Game saved = *g;
+	State_Key key;
+	state_encode(&key, false);
+
+	STALE(&g->player);
+	STALE(&g->landmark);
+	STALE(&g->chest);
+	STALE(&g->fly_fruit);
+	STALE(&g->fruit);
+	STALE(&g->orb);
+	if (!g->fake_wall.active)
+	{
+		memset(&g->fake_wall, 0xa5, sizeof(Object));
+		g->fake_wall.active = false;
+	}
+	if (!g->key.active)
+	{
+		memset(&g->key, 0xa5, sizeof(Object));
+		g->key.active = false;
+	}
+	if (!g->player_spawn.active)
+	{
+		memset(&g->player_spawn, 0xa5, sizeof(Player_Spawn));
+		g->player_spawn.active = false;
+	}
+	for (u8 i = 0; i < MAX_BALLOONS; i++)
+		STALE(&g->balloons[i]);
+	for (u8 i = 0; i < MAX_FALL_FLOORS; i++)
+		STALE(&g->fall_floors[i]);
+	for (u8 i = 0; i < MAX_PLATFORMS; i++)
+		STALE(&g->platforms[i]);
+	for (u8 i = 0; i < MAX_SPRINGS; i++)
+		STALE(&g->springs[i]);
+
+	expect(same_key(&key, false), "stale fields of inactive slots changed the key", level);
+	*g = saved;
+}
+
+static void check_unread_fields(u8 level)
+{
+	Game saved = *g;
+	State_Key key;
+
+	g->player.dash_time = 0;
+	state_encode(&key, false);
+
+	g->player.dash_target.x = -g->player.dash_target.x + 3;
+	g->player.dash_accel.y = 0.5f;
+	g->shake = 7;
+	if (!g->fake_wall.active)
+		g->player.dash_effect_time = 9;
+	expect(same_key(&key, false), "fields nothing reads changed the key", level);
+
+	//and the dash's target counts while it dashes
+	if (g->player.obj.active)
+	{
+		g->player.dash_time = 2;
+		state_encode(&key, false);
+		g->player.dash_target.x += 1;
+		expect(!same_key(&key, false), "the target of a dash is missing from the key", level);
+	}
+	*g = saved;
+}
+
+static void check_rng(u8 level)
+{
+	u32 seed = rnd_seed;
+	State_Key key, with_rng;
+	state_encode(&key, false);
+	state_encode(&with_rng, true);
+
+	rnd_seed = ~seed;
+	expect(same_key(&key, false), "the rng changed the key", level);
+	expect(!same_key(&with_rng, true), "the rng is missing from the key asked to hold it", level);
+
+	rnd_seed = seed;
+}
+
+
+//-- main --
+//----------
+int main(void)
+{
+	Game game = GAME_INIT;
+	g = &game;
+
+	for (u8 level = 0; level < ROOMS; level++)
+	{
+		play_room(level);
+		check_save_load(level);
+		check_negative_zero(level);
+		check_stale_slots(level);
+		check_unread_fields(level);
+		check_rng(level);
+	}
+
+	if (failures > 0)
+	{
+		printf("state keys: %u failures\n", failures);
+		return 1;
+	}
+	printf("state keys: %u rooms ok\n", ROOMS);
+	return 0;
+}